@@ -1,18 +1,23 @@
 
 #include <dbAccess.h>
 #include <dbConvertFast.h>
+#include <dbConvert.h>
 #include <devSup.h>
 #include <recSup.h>
 #include <dbCommon.h>
 #include <dbBase.h>
 #include <errlog.h>
-#include <stdio.h> /* required by gpHash.h; epics 3.14.11 */
-#include <gpHash.h>
+#include <stdio.h>
 #include <recGbl.h>
 #include <alarm.h>
 #include <epicsExport.h>
 #include <cantProceed.h>
 #include <iocsh.h>
+#include <epicsTimer.h>
+#include <initHooks.h>
+#include <special.h>
+#include <menuScan.h>
+#include <callback.h>
 
 #include <string.h>
 #include <stdlib.h>
@@ -22,6 +27,8 @@
 #include <epicsThread.h>
 
 #include "devGenVar.h"
+#include "devGenVarReg.h"
+#include "devGenVarArena.h"
 
 #if   ! defined(EPICS_VERSION)      \
    || ! defined(EPICS_REVISION)     \
@@ -29,551 +36,2820 @@
 #error "Unknown EPICS Version"
 #endif
 
-/* I Loooooove changing APIs. Really, I do... */
-#if      EPICS_VERSION > 3 \
-    || ( EPICS_VERSION == 3 && EPICS_REVISION > 14 ) \
-    || ( EPICS_VERSION == 3 && EPICS_REVISION == 14 && EPICS_MODIFICATION > 10 )
-#define HAVE_EPICS_31411
-#endif
-
-#define REG_LD_TBL_SZ_DEFAULT 9
-
 #define FLG_NCONV    (1<<0)
 #define FLG_ASYNC    (1<<1)
 #define FLG_NPOST    (1<<2)
 #define FLG_NCSUP    (1<<31)
 
+#define GV_NELMS(gv) ((gv)->n_elms ? (gv)->n_elms : 1)
+
+/* GenVar holding ts/stat/sevr; struct members use their template's */
+#define GV_STS(gv)   ((gv)->tmpl ? (gv)->tmpl : (gv))
+
+/* Conversion routine (as found in the dbFastXXXConvertRoutine tables) */
+typedef long (*GvCvt)(const void *from, void *to, dbAddr *paddr);
+
+/* Transfer kernels; selected once by devGenVarInitRec() */
+#define KERN_CVT     0    /* use rd_cvt/wr_cvt                        */
+#define KERN_CPY1    1    /* identical types; copy 1 byte             */
+#define KERN_CPY2    2    /* identical types; copy 2 bytes            */
+#define KERN_CPY4    3    /* identical types; copy 4 bytes            */
+#define KERN_CPY8    4    /* identical types; copy 8 bytes            */
+#define KERN_ARR     5    /* array record; arrGet/arrPut              */
+#define KERN_STR     6    /* string field <-> string GenVar; strGet/strPut */
+
 typedef struct DevGenVarPvtRec_ {
 	DevGenVar   gv;
 	epicsUInt32 flags;
 	dbAddr      dbaddr;
+	epicsUInt32 *nord_p;    /* array records only: NORD field */
+	unsigned    kern;       /* KERN_XXX                       */
+	GvCvt       rd_cvt;     /* GenVar -> record field         */
+	GvCvt       wr_cvt;     /* record field -> GenVar         */
+	struct DevGenVarAsyncRec_ *arec; /* asynchronous records only */
+	epicsUInt32 gen;        /* DEV_GEN_VAR_OPT_DIRTY: last generation read */
 } DevGenVarPvtRec, *DevGenVarPvt;
 
-typedef struct RegHeadRec_ {
-	DevGenVar  gv;
-	int        n_entries;
-	char       name[];
-} RegHeadRec, *RegHead;
+/* Arenas for objects which live as long as the IOC.
+ * DPVTs are first allocated from 'dpvtInitArena'. Once
+ * all records are initialized they are copied to 'dpvtArena'
+ * sorted by scan-list so that records which are processed
+ * together also sit together in memory (see dpvtCompact()).
+ */
+static DevGenVarArenaRec dpvtInitArena = DEV_GEN_VAR_ARENA_INIT("DPVT (init)");
+static DevGenVarArenaRec dpvtArena     = DEV_GEN_VAR_ARENA_INIT("DPVT");
+static DevGenVarArenaRec regArena      = DEV_GEN_VAR_ARENA_INIT("Registry");
+static DevGenVarArenaRec scanArena     = DEV_GEN_VAR_ARENA_INIT("IOSCANPVT");
+
+/* All DPVTs (for compaction and reporting) */
+static DevGenVarPvt     *dpvtList      = 0;
+static unsigned long     dpvtListLen   = 0;
+static unsigned long     dpvtListCap   = 0;
+static int               dpvtCompacted = 0;
 
-#ifdef HAVE_EPICS_31411
-struct gphPvt
-#else
-void
-#endif
-*devGenVarRegistry  = 0;
+int
+devGenVarConfig(unsigned ldTblSz)
+{
+	/* The registry grows by itself; nothing to configure anymore */
+	return 0;
+}
 
-static unsigned regLdTblSz = REG_LD_TBL_SZ_DEFAULT;
+/* Rate-limited scanning; one limiter per scan-list */
 
-static epicsThreadOnceId once_id = 0;
+typedef struct DevGenVarScanLimRec_ {
+	struct DevGenVarScanLimRec_ *next;
+	IOSCANPVT      *scan_p;
+	double          period;
+	epicsTimeStamp  last;      /* time of last scan                 */
+	int             pending;   /* scan is due (issued or scheduled) */
+	epicsTimerId    tmr;
+	unsigned long   n_req, n_scan, n_coal;
+} DevGenVarScanLimRec, *DevGenVarScanLim;
 
-static void init_once_fn(void *unused)
-{
-	if ( ! devGenVarRegistry ) {
-		gphInitPvt( &devGenVarRegistry, (1 << regLdTblSz) );
+static DevGenVarScanLim  scanLimList = 0;
+static epicsTimerQueueId scanLimQ    = 0;
 
-		if ( ! devGenVarRegistry ) 
-			cantProceed("devGenVar: Unable to create hash table\n");
-	}
+static void
+scanLimNow(DevGenVarScanLim l)
+{
+	/* Clear 'pending' *before* requesting so that a concurrent
+	 * request either is covered by this scan or schedules its own.
+	 */
+	__atomic_store_n( &l->pending, 0, __ATOMIC_RELEASE );
+	__atomic_fetch_add( &l->n_scan, 1, __ATOMIC_RELAXED );
+	scanIoRequest( *l->scan_p );
 }
 
-static void init_once()
+static void
+scanLimTimeout(void *arg)
 {
-	epicsThreadOnce( &once_id, init_once_fn, 0 );
+DevGenVarScanLim l = arg;
+
+	epicsTimeGetCurrent( &l->last );
+	scanLimNow( l );
 }
 
-int
-devGenVarConfig(unsigned ldTblSz)
+void
+devGenVarScanLimited(DevGenVarScanLim l)
 {
-	if ( ldTblSz < 8 || ldTblSz > 16 ) {
-		errlogPrintf("devGenVarConfig(): ldTableSize argument must be in 8..16\n");
-		return (1 << regLdTblSz);
+epicsTimeStamp now;
+double         dt;
+
+	__atomic_fetch_add( &l->n_req, 1, __ATOMIC_RELAXED );
+
+	if ( __atomic_exchange_n( &l->pending, 1, __ATOMIC_ACQ_REL ) ) {
+		/* a scan is already due; it picks up this update */
+		__atomic_fetch_add( &l->n_coal, 1, __ATOMIC_RELAXED );
+		return;
 	}
-	if ( devGenVarRegistry ) {
-		/* Already initialized; return current size */
-		return (1 << regLdTblSz);
+
+	epicsTimeGetCurrent( &now );
+	dt = epicsTimeDiffInSeconds( &now, &l->last );
+
+	if ( dt >= l->period ) {
+		l->last = now;
+		scanLimNow( l );
+	} else {
+		epicsTimerStartDelay( l->tmr, l->period - dt );
 	}
-	regLdTblSz = ldTblSz;
-	return 0;
 }
 
 int
-devGenVarProcComplete(DevGenVar gv)
+devGenVarScanRate(const char *name, double max_rate)
 {
-int rval;
+RegHead          h;
+DevGenVarScanLim l;
+int              i;
 
-	if ( ! gv->rec_p )
+	if ( ! (h = devGenVarRegFind( name )) ) {
+		errlogPrintf("devGenVarScanRate: no registry entry found for %s\n", name ? name : "<NULL>");
 		return -1;
+	}
 
-	devGenVarLock( gv );
-		/* Test again in case it changed */
-		if ( gv->rec_p ) {
-			dbScanLock( gv->rec_p );
-				/* process nests mutex lock */
-				gv->rec_p->rset->process(gv->rec_p);
-			dbScanUnlock( gv->rec_p );
-
-			gv->rec_p = 0;
-			rval = 0;
-		} else {
-			rval = -1;
+	for ( i = 0; i < h->n_entries; i++ ) {
+		if ( ! h->gv[i].scan_p )
+			continue;
+
+		if ( max_rate <= 0. ) {
+			h->gv[i].scan_lim = 0;
+			continue;
 		}
-	devGenVarUnlock( gv );
 
-	return rval;
+		for ( l = scanLimList; l; l = l->next ) {
+			if ( l->scan_p == h->gv[i].scan_p )
+				break;
+		}
+
+		if ( ! l ) {
+			if ( ! scanLimQ )
+				scanLimQ = epicsTimerQueueAllocate( 1, epicsThreadPriorityScanHigh );
+			if ( ! (l = calloc( 1, sizeof(*l) )) ) {
+				errlogPrintf("devGenVarScanRate: no memory\n");
+				return -1;
+			}
+			l->scan_p   = h->gv[i].scan_p;
+			l->tmr      = epicsTimerQueueCreateTimer( scanLimQ, scanLimTimeout, l );
+			l->next     = scanLimList;
+			scanLimList = l;
+		}
+
+		l->period         = 1./max_rate;
+		h->gv[i].scan_lim = l;
+	}
+	return 0;
 }
 
-int
-devGenVarPhase2(dbCommon *prec, DevGenVar gv)
+void
+devGenVarScanRateShow(void)
 {
-	if ( ! prec->pact ) {
-		/* not phase 2 */
-		return -1;
-	}
-	if ( epicsTimeEventDeviceTime == prec->tse ) {
-		prec->time = gv->ts;
+DevGenVarScanLim l;
+
+	for ( l = scanLimList; l; l = l->next ) {
+		printf("scan-list %p: max. rate %8.1f/s, requests %10lu, scans %10lu, coalesced %10lu\n",
+			(void*)l->scan_p, 1./l->period, l->n_req, l->n_scan, l->n_coal);
 	}
-	recGblSetSevr( prec, gv->stat, gv->sevr );
+}
 
+/* Records in asynchronous processing (phase 1 done).
+ * The capacity is the number of asynchronous records
+ * attached to the GenVar, hence pushing a record (which
+ * can be pending only once) never fails.
+ * Protected by the GenVar's lock.
+ */
+typedef struct DevGenVarAsyncQRec_ {
+	unsigned   cap;
+	unsigned   head;    /* oldest pending record */
+	unsigned   n;       /* # of pending records  */
+	dbCommon  *rec[];
+} DevGenVarAsyncQRec, *DevGenVarAsyncQ;
+
+/* Called from init_record; grow the queue by one slot */
+static long
+asyncQAttach(DevGenVar gv)
+{
+DevGenVarAsyncQ q;
+unsigned        cap = gv->asyncq ? gv->asyncq->cap + 1 : 1;
+
+	if ( ! (q = realloc( gv->asyncq, sizeof(*q) + cap * sizeof(q->rec[0]) )) )
+		return S_db_noMemory;
+	if ( ! gv->asyncq ) {
+		q->head = 0;
+		q->n    = 0;
+	}
+	q->cap     = cap;
+	gv->asyncq = q;
 	return 0;
 }
 
-long
-devGenVarRegister(const char *registryEntry, DevGenVar gv, int n_entries)
+static int
+asyncQPush(DevGenVarAsyncQ q, dbCommon *prec)
 {
-RegHead   h = 0;
-GPHENTRY *he;
+	if ( ! q || q->n >= q->cap )
+		return -1;
+	q->rec[ (q->head + q->n) % q->cap ] = prec;
+	q->n++;
+	return 0;
+}
 
-	init_once();
+/* Remove 'prec' (or the oldest record if 'prec' is NULL) */
+static dbCommon *
+asyncQRemove(DevGenVarAsyncQ q, dbCommon *prec)
+{
+unsigned k;
 
-	if ( 0 == n_entries )
+	if ( ! q || 0 == q->n )
 		return 0;
 
-	if ( ! registryEntry || !gv )
-		return -1;
-	
-	if ( ! (h = malloc(sizeof(*h) + strlen(registryEntry) + 1)) ) {
-		errlogPrintf("devGenVarRegister: no memory\n");
-		return -1;
+	if ( ! prec || prec == q->rec[q->head] ) {
+		prec    = q->rec[q->head];
+		q->head = (q->head + 1) % q->cap;
+		q->n--;
+		return prec;
 	}
 
-	h->n_entries = n_entries;
-	h->gv        = gv;
-	strcpy(h->name, registryEntry);
-
-	if ( ! (he = gphAdd(devGenVarRegistry, h->name, devGenVarRegistry)) ) {
-		errlogPrintf("devGenVarRegister: Unable to add entry '%s'\n", registryEntry);
-		free(h);
-		return -1;
+	for ( k = 1; k < q->n; k++ ) {
+		if ( prec == q->rec[ (q->head + k) % q->cap ] ) {
+			/* preserve order of the others */
+			for ( ; k < q->n - 1; k++ )
+				q->rec[ (q->head + k) % q->cap ] = q->rec[ (q->head + k + 1) % q->cap ];
+			q->n--;
+			return prec;
+		}
 	}
+	return 0;
+}
+
+/* Per-record state of an asynchronous record. Since a record is
+ * pending at most once this holds everything that belongs to its
+ * pending entry:
+ *  - the value (and alarm) an output record wrote in phase 1 so that
+ *    a later write to the same GenVar does not lose it (see
+ *    devGenVarProcPendingGet()),
+ *  - timestamp, status and severity which low-level code passed back
+ *    at devGenVarProcComplete() (used by phase 2),
+ *  - the CALLBACK for deferred completion (DEV_GEN_VAR_OPT_DEFER).
+ */
+typedef struct DevGenVarAsyncRec_ {
+	CALLBACK        cb;
+	dbCommon       *prec;
+	int             defer;
+	epicsTimeStamp  t_req;             /* deferral requested              */
+	epicsTimeStamp  ts;                /* passed back by low-level code   */
+	epicsEnum16     stat, sevr;
+	epicsEnum16     wr_stat, wr_sevr;  /* alarm of the record in phase 1  */
+	unsigned        n_val;             /* # elements in 'val' (0: input)  */
+	double          val[];             /* value written in phase 1        */
+} DevGenVarAsyncRec, *DevGenVarAsync;
+
+static DevGenVarArenaRec asyncArena = DEV_GEN_VAR_ARENA_INIT("Asynchronous records");
+
+/* Deferred completion (DEV_GEN_VAR_OPT_DEFER): phase 2 is run
+ * by an EPICS callback thread at priority 'devGenVarDeferPrio'.
+ * Every asynchronous record owns one CALLBACK; since a record
+ * is pending at most once it can never be requested twice.
+ */
+int devGenVarDeferPrio = priorityMedium;
+epicsExportAddress(int, devGenVarDeferPrio);
+
+/* Updated atomically; depth = n_req - n_done - n_fail */
+static struct {
+	unsigned long n_req, n_done, n_fail;
+	unsigned long depth_max;
+	epicsUInt64   dly_tot, dly_max;    /* ns */
+} deferStats;
+
+static void
+atomicMax(epicsUInt64 *max_p, epicsUInt64 val)
+{
+epicsUInt64 old = __atomic_load_n( max_p, __ATOMIC_RELAXED );
+
+	while ( val > old && ! __atomic_compare_exchange_n( max_p, &old, val, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+		/* retry */;
+}
+
+static void
+deferCallback(CALLBACK *cb)
+{
+DevGenVarAsync d;
+epicsTimeStamp now;
+epicsUInt64    dly;
+
+	callbackGetUser( d, cb );
+
+	epicsTimeGetCurrent( &now );
+	dly = (epicsUInt64)(epicsTimeDiffInSeconds( &now, &d->t_req ) * 1.0E9);
+	__atomic_fetch_add( &deferStats.dly_tot, dly, __ATOMIC_RELAXED );
+	atomicMax( &deferStats.dly_max, dly );
+
+	/* The GenVar's lock must not be held here: phase 1 (and phase 2)
+	 * take it while holding the lock set.
+	 */
+	dbScanLock( d->prec );
+		d->prec->rset->process( d->prec );
+	dbScanUnlock( d->prec );
+
+	__atomic_fetch_add( &deferStats.n_done, 1, __ATOMIC_RELAXED );
+}
 
-	he->userPvt = h;
+static long
+asyncAttach(DevGenVarPvt p, dbCommon *prec)
+{
+DevGenVarAsync d;
+size_t         vsz = GV_NELMS( p->gv ) * dbValueSize( p->gv->dbr_t );
+
+	if ( ! (d = devGenVarArenaAlloc( &asyncArena, sizeof(*d) + vsz, sizeof(double) )) )
+		return S_db_noMemory;
+	memset( d, 0, sizeof(*d) );
+	d->prec  = prec;
+	d->defer = !! (p->gv->opts & DEV_GEN_VAR_OPT_DEFER);
+	callbackSetCallback( deferCallback, &d->cb );
+	callbackSetUser( d, &d->cb );
+	p->arec  = d;
 	return 0;
 }
 
-long 
-devGenVarGet_nolock(dbCommon *prec)
+/* Phase 1 of an output record: keep a copy of the 'n' elements
+ * just written (at 'src') with the pending entry.
+ */
+static void
+asyncSave(DevGenVarPvt p, dbCommon *prec, volatile void *src, unsigned n, long status)
 {
-DevGenVarPvt       p = prec->dpvt;
-DevGenVar         gv = p->gv;
-unsigned short dbf_t = p->dbaddr.field_type;
-unsigned short dbr_t = gv->dbr_t;
-long          status;
+DevGenVarAsync d = p->arec;
 
-	if ( dbf_t > DBF_DEVICE || dbr_t > DBR_ENUM )
-		return -1;
+	memcpy( d->val, (void*)src, n * dbValueSize( p->gv->dbr_t ) );
+	d->n_val   = n;
+	d->wr_stat = prec->stat;
+	d->wr_sevr = status ? INVALID_ALARM : prec->sevr;
+}
 
-	/* 'put' from outside data buffer to rec. field */
-	status = (* (dbFastPutConvertRoutine[dbr_t][dbf_t]))(gv->data_p, p->dbaddr.pfield, &p->dbaddr);
+/* Queue phase 2 of 'prec' */
+static int
+deferRequest(dbCommon *prec)
+{
+DevGenVarAsync d = ((DevGenVarPvt)prec->dpvt)->arec;
+unsigned long  depth;
+int            prio = devGenVarDeferPrio;
 
-	/* Use timestamp, status and severity */
-	if ( epicsTimeEventDeviceTime == prec->tse )
-		prec->time = gv->ts;
+	if ( prio < priorityLow || prio > priorityHigh )
+		prio = priorityMedium;
 
-	recGblSetSevr( prec, gv->stat, gv->sevr );
+	epicsTimeGetCurrent( &d->t_req );
+	callbackSetPriority( prio, &d->cb );
 
-	if ( status )
-		recGblSetSevr( prec, READ_ALARM, INVALID_ALARM );
-	else if ( (p->flags & FLG_NCONV) ) {
-		/* No conversion */
-		prec->udf = FALSE;
-		status = 2;
-	}
+	depth = __atomic_add_fetch( &deferStats.n_req, 1, __ATOMIC_RELAXED )
+	      - __atomic_load_n( &deferStats.n_done, __ATOMIC_RELAXED )
+	      - __atomic_load_n( &deferStats.n_fail, __ATOMIC_RELAXED );
+	if ( depth > __atomic_load_n( &deferStats.depth_max, __ATOMIC_RELAXED ) )
+		__atomic_store_n( &deferStats.depth_max, depth, __ATOMIC_RELAXED );
 
-	if ( gv->evt && ! (p->flags & FLG_NPOST) ) {
-		epicsEventSignal( gv->evt );
+	if ( callbackRequest( &d->cb ) ) {
+		__atomic_fetch_add( &deferStats.n_fail, 1, __ATOMIC_RELAXED );
+		return -1;
 	}
-
-	return status;
+	return 0;
 }
 
 long
-devGenVarReadback_nolock(dbCommon *prec)
+devGenVarDeferShow(int reset)
 {
-DevGenVarPvt       p = prec->dpvt;
-DevGenVar         gv = p->gv;
-unsigned short dbf_t = p->dbaddr.field_type;
-unsigned short dbr_t = gv->dbr_t;
-long          status;
+unsigned long n_req  = __atomic_load_n( &deferStats.n_req,  __ATOMIC_RELAXED );
+unsigned long n_done = __atomic_load_n( &deferStats.n_done, __ATOMIC_RELAXED );
+unsigned long n_fail = __atomic_load_n( &deferStats.n_fail, __ATOMIC_RELAXED );
+epicsUInt64   tot    = __atomic_load_n( &deferStats.dly_tot, __ATOMIC_RELAXED );
+
+	printf("Deferred completion (priority %i):\n", devGenVarDeferPrio);
+	printf("  requested: %lu, completed: %lu, callback queue full: %lu\n", n_req, n_done, n_fail);
+	printf("  queue depth: %lu now, %lu max\n", n_req - n_done - n_fail, deferStats.depth_max);
+	printf("  phase-2 delay: %.1fus avg, %.1fus max\n",
+		n_done ? (double)tot * 1.0E-3 / (double)n_done : 0.,
+		(double)deferStats.dly_max * 1.0E-3);
+
+	if ( reset ) {
+		/* pending requests still count towards the depth */
+		__atomic_store_n( &deferStats.depth_max, n_req - n_done - n_fail, __ATOMIC_RELAXED );
+		__atomic_store_n( &deferStats.dly_tot,   0, __ATOMIC_RELAXED );
+		__atomic_store_n( &deferStats.dly_max,   0, __ATOMIC_RELAXED );
+		__atomic_fetch_sub( &deferStats.n_req,  n_done + n_fail, __ATOMIC_RELAXED );
+		__atomic_fetch_sub( &deferStats.n_done, n_done, __ATOMIC_RELAXED );
+		__atomic_fetch_sub( &deferStats.n_fail, n_fail, __ATOMIC_RELAXED );
+	}
+	return 0;
+}
 
-	if ( dbf_t > DBF_DEVICE || dbr_t > DBR_ENUM )
+static int
+procComplete(DevGenVar gv, dbCommon *prec)
+{
+DevGenVarAsync d;
+
+	if ( ! gv->asyncq )
 		return -1;
 
-	status = (* (dbFastPutConvertRoutine[dbr_t][dbf_t]))(gv->data_p, p->dbaddr.pfield, &p->dbaddr);
+	devGenVarLock( gv );
+		if ( (prec = asyncQRemove( gv->asyncq, prec )) ) {
+			/* what low-level code passes back belongs to this record */
+			d       = ((DevGenVarPvt)prec->dpvt)->arec;
+			d->ts   = GV_STS( gv )->ts;
+			d->stat = GV_STS( gv )->stat;
+			d->sevr = GV_STS( gv )->sevr;
+		}
+	devGenVarUnlock( gv );
+
+	if ( ! prec )
+		return -1;
 
-	if ( status ) {
-		recGblRecordError(status, prec, "Unable to read current value back\n");
-		recGblSetSevr(prec, READ_ALARM, MAJOR_ALARM);
-		/* Propagate stat, sevr and timestamp out to GenVar. This is normally
-		 * done by devGenVarPut but if devsup uses this routine it should
-		 * omit devGenVarPut when reading back fails.
-		 */
-		gv->stat = prec->stat;
-		gv->sevr = prec->sevr;
+	/* Phase 1 takes the lock set and then the GenVar's lock; hence
+	 * the latter must have been released before locking the record.
+	 * The record still has PACT set and cannot be queued again.
+	 */
+	if ( ! d->defer || deferRequest( prec ) ) {
+		/* run phase 2 right here (also if the callback queue is full) */
+		dbScanLock( prec );
+			prec->rset->process( prec );
+		dbScanUnlock( prec );
 	}
 
-	return status;
+	return 0;
 }
 
-long
-devGenVarGet(dbCommon *prec)
+int
+devGenVarProcComplete(DevGenVar gv)
 {
-DevGenVarPvt       p = prec->dpvt;
-DevGenVar         gv = p->gv;
-long          status;
+	return procComplete( gv, 0 );
+}
 
-	if ( ! gv->mtx )
-		return devGenVarGet_nolock( prec );
+int
+devGenVarProcCompleteRec(DevGenVar gv, dbCommon *prec)
+{
+	if ( ! prec )
+		return -1;
+	return procComplete( gv, prec );
+}
 
-	epicsMutexMustLock( gv->mtx );
+int
+devGenVarProcPending(DevGenVar gv, dbCommon **oldest_p)
+{
+int n = 0;
 
-		status = devGenVarGet_nolock( prec );
+	if ( oldest_p )
+		*oldest_p = 0;
+
+	if ( ! gv->asyncq )
+		return 0;
 
-	epicsMutexUnlock( gv->mtx );
+	devGenVarLock( gv );
+		if ( (n = gv->asyncq->n) && oldest_p )
+			*oldest_p = gv->asyncq->rec[gv->asyncq->head];
+	devGenVarUnlock( gv );
 
-	return status;
+	return n;
 }
 
-long
-devGenVarPut_nolock(dbCommon *prec)
+int
+devGenVarProcPendingGet(DevGenVar gv, void *buf, epicsEnum16 *stat_p, epicsEnum16 *sevr_p, dbCommon **prec_p)
 {
-DevGenVarPvt       p = prec->dpvt;
-DevGenVar         gv = p->gv;
-unsigned short dbf_t = p->dbaddr.field_type;
-unsigned short dbr_t = gv->dbr_t;
-long     status;
+int            rval = -1;
+dbCommon      *prec;
+DevGenVarAsync d;
 
-	if ( dbf_t > DBF_DEVICE || dbr_t > DBR_ENUM )
-		return -1;
+	if ( prec_p )
+		*prec_p = 0;
 
-	if ( 0 == devGenVarPhase2( prec, gv ) ) {
-		/* phase 2 */
-		return 0;
-	}
+	if ( ! gv->asyncq )
+		return -1;
 
-	/* Is asynchronous processing requested ? */
-	if ( (p->flags & FLG_ASYNC) ) {
-		if ( gv->rec_p ) {
-			recGblRecordError(S_dev_Conflict, prec, "Only ONE record may asynchronously process a GenVar\n");
-			recGblSetSevr( prec, WRITE_ALARM, INVALID_ALARM );
-			return -1;
+	devGenVarLock( gv );
+		if ( gv->asyncq->n ) {
+			prec = gv->asyncq->rec[gv->asyncq->head];
+			d    = ((DevGenVarPvt)prec->dpvt)->arec;
+			if ( (rval = d->n_val) ) {
+				if ( buf )
+					memcpy( buf, d->val, d->n_val * dbValueSize( gv->dbr_t ) );
+				if ( stat_p )
+					*stat_p = d->wr_stat;
+				if ( sevr_p )
+					*sevr_p = d->wr_sevr;
+			}
+			if ( prec_p )
+				*prec_p = prec;
 		}
-		/* Initiate phase 1 */
-		gv->rec_p  = prec;
-		prec->pact = TRUE;
-	}
-
-	status = (* (dbFastGetConvertRoutine[dbf_t][dbr_t]))(p->dbaddr.pfield, gv->data_p, &p->dbaddr);
+	devGenVarUnlock( gv );
 
-	if ( status ) {
-		recGblSetSevr( prec, WRITE_ALARM, INVALID_ALARM );
-	}
+	return rval;
+}
 
-	gv->stat = prec->stat;
-	gv->sevr = prec->sevr;
+int
+devGenVarPhase2(dbCommon *prec, DevGenVar gv)
+{
+DevGenVarAsync d = ((DevGenVarPvt)prec->dpvt)->arec;
 
-	if ( gv->evt && ! (p->flags & FLG_NPOST) ) {
-		epicsEventSignal( gv->evt );
+	if ( ! prec->pact ) {
+		/* not phase 2 */
+		return -1;
+	}
+	if ( d ) {
+		/* as passed back when this record was completed */
+		if ( epicsTimeEventDeviceTime == prec->tse ) {
+			prec->time = d->ts;
+		}
+		recGblSetSevr( prec, d->stat, d->sevr );
+	} else {
+		if ( epicsTimeEventDeviceTime == prec->tse ) {
+			prec->time = GV_STS( gv )->ts;
+		}
+		recGblSetSevr( prec, GV_STS( gv )->stat, GV_STS( gv )->sevr );
 	}
 
-	return status;
+	return 0;
 }
 
 long
-devGenVarPut(dbCommon *prec)
+devGenVarRegister(const char *registryEntry, DevGenVar gv, int n_entries)
 {
-DevGenVarPvt       p = prec->dpvt;
-DevGenVar         gv = p->gv;
-long          status;
+RegHead   h = 0;
 
-	if ( ! gv->mtx )
-		return devGenVarPut_nolock( prec );
+	if ( 0 == n_entries )
+		return 0;
 
-	epicsMutexMustLock( gv->mtx );
+	if ( ! registryEntry || !gv )
+		return -1;
 
-		status = devGenVarPut_nolock( prec );
+	if ( devGenVarRegFind( registryEntry ) ) {
+		errlogPrintf("devGenVarRegister: entry '%s' exists already\n", registryEntry);
+		return -1;
+	}
+	
+	if ( ! (h = devGenVarArenaAlloc( &regArena, sizeof(*h) + strlen(registryEntry) + 1, sizeof(double) )) ) {
+		errlogPrintf("devGenVarRegister: no memory\n");
+		return -1;
+	}
 
-	epicsMutexUnlock( gv->mtx );
+	h->n_entries = n_entries;
+	h->gv        = gv;
+	strcpy(h->name, registryEntry);
 
-	return status;
+	if ( devGenVarRegAdd( h ) ) {
+		/* 'h' is lost in the arena; only happens on a race */
+		errlogPrintf("devGenVarRegister: Unable to add entry '%s'\n", registryEntry);
+		return -1;
+	}
+
+	return 0;
 }
 
 long
-devGenVarInitScanPvt( DevGenVar p, int n_entries )
+devGenVarRegisterStruct(const char *registryEntry, DevGenVar p, const DevGenVarMemberRec *members, int n_members)
 {
-int i;
+RegHead h;
+int     i;
 
-	devGenVarInit( p, n_entries );
+	if ( ! p || ! members || n_members <= 0 )
+		return -1;
 
-	for ( i = 0; i < n_entries; i++ ) {
-		if ( ! (p[i].scan_p = malloc( sizeof(IOSCANPVT) )) )
+	if ( (p->opts & DEV_GEN_VAR_OPT_SEQLOCK) || p->snap || p->fifo ) {
+		/* members would not share the template's seq. counter / copies / queue */
+		errlogPrintf("devGenVarRegisterStruct: '%s' template must not be in SEQLOCK mode, a snapshot group or have a FIFO\n", registryEntry);
+		return -1;
+	}
+
+	for ( i = 0; i < n_members; i++ ) {
+		if ( ! members[i].name || members[i].dbr_t > DBR_ENUM ) {
+			errlogPrintf("devGenVarRegisterStruct: '%s' member #%i invalid\n", registryEntry, i);
 			return -1;
-		scanIoInit( p[i].scan_p );
+		}
 	}
-	return 0;
-}
 
+	if ( devGenVarRegister( registryEntry, p, 1 ) )
+		return -1;
 
-long
-devGenVarGetIointInfo(int delFrom, dbCommon *prec, IOSCANPVT *ppvt)
-{
-DevGenVar gv = ((DevGenVarPvt)prec->dpvt)->gv;
+	/* nobody else can have seen the new entry yet */
+	h            = devGenVarRegFind( registryEntry );
+	h->members   = members;
+	h->n_members = n_members;
 
-	if ( ! (gv->scan_p) )
-		return -1;
-	*ppvt = *gv->scan_p;
 	return 0;
 }
 
-static void *
-findEntry(const char *name)
+/* Find "<struct>.<member>"; create the member's GenVar on first use */
+static RegHead
+structMemberFind(const char *name)
 {
-GPHENTRY *he;
+const char *dot = strrchr( name, '.' );
+char        buf[256];
+size_t      len;
+RegHead     s;
+DevGenVar   gv;
+int         i;
+
+	if ( ! dot || (len = dot - name) >= sizeof(buf) )
+		return 0;
 
-	init_once();
+	memcpy( buf, name, len );
+	buf[len] = 0;
 
-	if ( ! name )
+	if ( ! (s = devGenVarRegFind( buf )) || ! s->members )
 		return 0;
-	if ( ! (he = gphFind( devGenVarRegistry, name, devGenVarRegistry )) )
+
+	for ( i = 0; i < s->n_members; i++ ) {
+		if ( 0 == strcmp( s->members[i].name, dot + 1 ) )
+			break;
+	}
+	if ( i == s->n_members )
+		return 0;
+
+	if ( (s->gv->opts & DEV_GEN_VAR_OPT_SEQLOCK) || s->gv->snap || s->gv->fifo ) {
+		/* set after devGenVarRegisterStruct() */
+		errlogPrintf("devGenVar: '%s' struct template in SEQLOCK mode, snapshot group or with FIFO\n", buf);
+		return 0;
+	}
+
+	if ( ! (gv = devGenVarArenaAlloc( &regArena, sizeof(*gv), sizeof(double) )) )
+		return 0;
+
+	/* shared with all members */
+	gv->scan_p   = s->gv->scan_p;
+	gv->mtx      = s->gv->mtx;
+	gv->evt      = s->gv->evt;
+	/* members are not marked individually */
+	gv->opts     = s->gv->opts & ~DEV_GEN_VAR_OPT_DIRTY;
+	gv->deadband = s->gv->deadband;
+	gv->scan_lim = s->gv->scan_lim;
+	/* ts, stat and sevr */
+	gv->tmpl     = s->gv;
+
+	gv->data_p   = (volatile char*)s->gv->data_p + s->members[i].offset;
+	gv->dbr_t    = s->members[i].dbr_t;
+	gv->n_elms   = s->members[i].n_elms;
+
+	if ( devGenVarRegister( name, gv, 1 ) )
+		return 0;
+
+	return devGenVarRegFind( name );
+}
+
+/* Snapshot groups */
+
+typedef struct SnapBuf_ {
+	epicsTimeStamp ts;
+	epicsEnum16    stat, sevr;
+	unsigned       pins;       /* # of readers using this copy */
+	char          *data;
+} SnapBuf;
+
+typedef struct DevGenVarSnapRec_ {
+	IOSCANPVT     *scan_p;
+	size_t         size;
+	unsigned       front;      /* index of copy readers use        */
+	int            stale;      /* back copy must be refreshed      */
+	int            owned;      /* producer obtained back copy      */
+	DevGenVar      gv;         /* member on 'scan_p' (for scanning) */
+	SnapBuf        buf[2];
+} DevGenVarSnapRec;
+
+DevGenVarSnap
+devGenVarSnapCreate(size_t size, IOSCANPVT *scan_p)
+{
+DevGenVarSnap s;
+
+	if ( ! (s = calloc( 1, sizeof(*s) )) ) {
+		errlogPrintf("devGenVarSnapCreate: no memory\n");
+		return 0;
+	}
+	if ( ! (s->buf[0].data = calloc( 2, size )) ) {
+		errlogPrintf("devGenVarSnapCreate: no memory\n");
+		free( s );
+		return 0;
+	}
+	s->buf[1].data = s->buf[0].data + size;
+	s->size        = size;
+	s->scan_p      = scan_p;
+	return s;
+}
+
+long
+devGenVarSnapAttach(DevGenVar p, DevGenVarSnap s, size_t offset)
+{
+	if ( p->dbr_t > DBR_ENUM || offset + GV_NELMS( p ) * dbValueSize( p->dbr_t ) > s->size ) {
+		errlogPrintf("devGenVarSnapAttach: variable at offset %lu does not fit into group\n", (unsigned long)offset);
+		return -1;
+	}
+	if ( (p->opts & DEV_GEN_VAR_OPT_DIRTY) ) {
+		/* devGenVarSnapPublish() does not know which members changed */
+		errlogPrintf("devGenVarSnapAttach: variable at offset %lu must not use DEV_GEN_VAR_OPT_DIRTY\n", (unsigned long)offset);
+		return -1;
+	}
+	p->snap     = s;
+	p->snap_off = offset;
+	if ( ! p->scan_p )
+		p->scan_p = s->scan_p;
+	/* publish scans through a member so that its rate-limiter and
+	 * statistics apply
+	 */
+	if ( ! s->gv && s->scan_p && p->scan_p == s->scan_p )
+		s->gv = p;
+	return 0;
+}
+
+void *
+devGenVarSnapBack(DevGenVarSnap s)
+{
+unsigned f = s->front;
+SnapBuf *b = &s->buf[1 - f];
+
+	/* Pairs with the reader's pin/re-check in snapPin() */
+	if ( __atomic_load_n( &b->pins, __ATOMIC_SEQ_CST ) )
+		return 0;
+
+	if ( s->stale ) {
+		memcpy( b->data, s->buf[f].data, s->size );
+		s->stale = 0;
+	}
+	s->owned = 1;
+	return b->data;
+}
+
+long
+devGenVarSnapPublish(DevGenVarSnap s, const epicsTimeStamp *ts, epicsEnum16 stat, epicsEnum16 sevr)
+{
+unsigned b = 1 - s->front;
+
+	if ( ! s->owned )
+		return -1;
+
+	if ( ts )
+		s->buf[b].ts = *ts;
+	else
+		epicsTimeGetCurrent( &s->buf[b].ts );
+	s->buf[b].stat = stat;
+	s->buf[b].sevr = sevr;
+
+	__atomic_store_n( &s->front, b, __ATOMIC_SEQ_CST );
+	s->owned = 0;
+	s->stale = 1;
+
+	if ( s->gv )
+		devGenVarScan( s->gv );
+	else if ( s->scan_p )
+		scanIoRequest( *s->scan_p );
+
+	return 0;
+}
+
+/* Reader: pin the front copy so the producer won't reuse it while
+ * we are reading.
+ */
+static SnapBuf *
+snapPin(DevGenVarSnap s)
+{
+unsigned f;
+
+	while ( 1 ) {
+		f = __atomic_load_n( &s->front, __ATOMIC_SEQ_CST );
+		__atomic_fetch_add( &s->buf[f].pins, 1, __ATOMIC_SEQ_CST );
+		/* If the copies were flipped in the meantime then the producer
+		 * may already be writing what we just pinned.
+		 */
+		if ( f == __atomic_load_n( &s->front, __ATOMIC_SEQ_CST ) )
+			return &s->buf[f];
+		__atomic_fetch_sub( &s->buf[f].pins, 1, __ATOMIC_RELEASE );
+	}
+}
+
+static void
+snapUnpin(SnapBuf *b)
+{
+	__atomic_fetch_sub( &b->pins, 1, __ATOMIC_RELEASE );
+}
+
+/* Output FIFO; bounded MPMC ring (D. Vyukov). Every cell
+ * carries a sequence number: a cell at position 'pos' may be
+ * written when seq == pos and read when seq == pos + 1.
+ */
+typedef struct FifoCell_ {
+	size_t          seq;
+	epicsTimeStamp  ts;
+	epicsEnum16     stat, sevr;
+	long            n;            /* valid elements */
+	double          data[];       /* aligned for any DBR type */
+} FifoCell;
+
+typedef struct DevGenVarFifoRec_ {
+	size_t          mask;
+	size_t          stride;       /* bytes per cell */
+	size_t          elsz;
+	unsigned long   n_ovfl;
+	int             dir;          /* DEV_GEN_VAR_FIFO_IN/OUT    */
+	int             armed;        /* input FIFO: scan requested */
+	char            pad0[DEV_GEN_VAR_CACHE_LINE];
+	size_t          enq;
+	char            pad1[DEV_GEN_VAR_CACHE_LINE - sizeof(size_t)];
+	size_t          deq;
+	char            pad2[DEV_GEN_VAR_CACHE_LINE - sizeof(size_t)];
+	char           *cells;
+} DevGenVarFifoRec, *DevGenVarFifo;
+
+#define FIFO_CELL(f, pos) ((FifoCell*)((f)->cells + ((pos) & (f)->mask) * (f)->stride))
+
+/* GenVar has a FIFO for the given direction */
+#define GV_FIFO_IN(gv)    ((gv)->fifo && DEV_GEN_VAR_FIFO_IN  == (gv)->fifo->dir)
+#define GV_FIFO_OUT(gv)   ((gv)->fifo && DEV_GEN_VAR_FIFO_OUT == (gv)->fifo->dir)
+
+long
+devGenVarFifoCreate(DevGenVar p, unsigned depth, int dir)
+{
+DevGenVarFifo f;
+size_t        n, i;
+
+	if ( p->fifo || p->dbr_t > DBR_ENUM || 0 == depth ) {
+		errlogPrintf("devGenVarFifoCreate: FIFO exists already or bad type/depth\n");
+		return -1;
+	}
+	if ( DEV_GEN_VAR_FIFO_IN != dir && DEV_GEN_VAR_FIFO_OUT != dir ) {
+		errlogPrintf("devGenVarFifoCreate: bad direction %i\n", dir);
+		return -1;
+	}
+
+	for ( n = 1; n < depth; n <<= 1 )
+		/* round up to power of two */;
+
+	if ( ! (f = calloc( 1, sizeof(*f) )) ) {
+		errlogPrintf("devGenVarFifoCreate: no memory\n");
+		return -1;
+	}
+
+	f->elsz   = dbValueSize( p->dbr_t );
+	f->stride = sizeof(FifoCell) + GV_NELMS( p ) * f->elsz;
+	f->stride = (f->stride + sizeof(double) - 1) & ~(sizeof(double) - 1);
+	f->mask   = n - 1;
+	f->dir    = dir;
+
+	if ( ! (f->cells = calloc( n, f->stride )) ) {
+		errlogPrintf("devGenVarFifoCreate: no memory\n");
+		free( f );
+		return -1;
+	}
+
+	for ( i = 0; i < n; i++ )
+		FIFO_CELL( f, i )->seq = i;
+
+	p->fifo = f;
+	return 0;
+}
+
+/* Claim the next cell for writing; NULL if the FIFO is full */
+static FifoCell *
+fifoClaim(DevGenVarFifo f)
+{
+size_t    pos = __atomic_load_n( &f->enq, __ATOMIC_RELAXED );
+FifoCell *c;
+long      dif;
+
+	while ( 1 ) {
+		c   = FIFO_CELL( f, pos );
+		dif = (long)(__atomic_load_n( &c->seq, __ATOMIC_ACQUIRE ) - pos);
+		if ( 0 == dif ) {
+			if ( __atomic_compare_exchange_n( &f->enq, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+				return c;
+		} else if ( dif < 0 ) {
+			__atomic_fetch_add( &f->n_ovfl, 1, __ATOMIC_RELAXED );
+			return 0;
+		} else {
+			pos = __atomic_load_n( &f->enq, __ATOMIC_RELAXED );
+		}
+	}
+}
+
+/* Publish a cell obtained from fifoClaim() */
+static void
+fifoCommit(FifoCell *c)
+{
+	__atomic_store_n( &c->seq, c->seq + 1, __ATOMIC_RELEASE );
+}
+
+/* Take the oldest cell for reading; NULL if the FIFO is empty */
+static FifoCell *
+fifoTake(DevGenVarFifo f)
+{
+size_t    pos = __atomic_load_n( &f->deq, __ATOMIC_RELAXED );
+FifoCell *c;
+long      dif;
+
+	while ( 1 ) {
+		c   = FIFO_CELL( f, pos );
+		dif = (long)(__atomic_load_n( &c->seq, __ATOMIC_ACQUIRE ) - (pos + 1));
+		if ( 0 == dif ) {
+			if ( __atomic_compare_exchange_n( &f->deq, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+				return c;
+		} else if ( dif < 0 ) {
+			return 0;
+		} else {
+			pos = __atomic_load_n( &f->deq, __ATOMIC_RELAXED );
+		}
+	}
+}
+
+/* Hand a cell obtained from fifoTake() back to the producers */
+static void
+fifoRelease(DevGenVarFifo f, FifoCell *c)
+{
+	__atomic_store_n( &c->seq, c->seq + f->mask, __ATOMIC_RELEASE );
+}
+
+/* Nonzero if the FIFO holds at least one published entry */
+static __inline__ int
+fifoPending(DevGenVarFifo f)
+{
+size_t pos = __atomic_load_n( &f->deq, __ATOMIC_RELAXED );
+
+	return __atomic_load_n( &FIFO_CELL( f, pos )->seq, __ATOMIC_ACQUIRE ) == pos + 1;
+}
+
+long
+devGenVarDequeue(DevGenVar p, void *buf, epicsTimeStamp *ts, epicsEnum16 *stat, epicsEnum16 *sevr)
+{
+DevGenVarFifo f = p->fifo;
+FifoCell     *c;
+long          n;
+
+	if ( ! GV_FIFO_OUT( p ) )
+		return -1;
+
+	if ( ! (c = fifoTake( f )) )
 		return 0;
-	return he->userPvt;
+
+	n = c->n;
+	memcpy( buf, c->data, n * f->elsz );
+	if ( ts )
+		*ts   = c->ts;
+	if ( stat )
+		*stat = c->stat;
+	if ( sevr )
+		*sevr = c->sevr;
+
+	fifoRelease( f, c );
+
+	return n;
+}
+
+long
+devGenVarPush(DevGenVar p, const void *val_p, long n, const epicsTimeStamp *ts, epicsEnum16 stat, epicsEnum16 sevr)
+{
+DevGenVarFifo f = p->fifo;
+FifoCell     *c;
+
+	if ( ! GV_FIFO_IN( p ) )
+		return -1;
+
+	if ( ! (c = fifoClaim( f )) )
+		return -1;
+
+	if ( n <= 0 || n > GV_NELMS( p ) )
+		n = GV_NELMS( p );
+
+	memcpy( c->data, val_p, n * f->elsz );
+	c->n    = n;
+	if ( ts )
+		c->ts = *ts;
+	else
+		epicsTimeGetCurrent( &c->ts );
+	c->stat = stat;
+	c->sevr = sevr;
+
+	fifoCommit( c );
+
+	/* one outstanding scan suffices; the record requests the next one */
+	if ( ! __atomic_exchange_n( &f->armed, 1, __ATOMIC_SEQ_CST ) )
+		devGenVarScan( p );
+
+	return 0;
 }
 
+unsigned long
+devGenVarFifoOverflows(DevGenVar p)
+{
+	return p->fifo ? __atomic_load_n( &p->fifo->n_ovfl, __ATOMIC_RELAXED ) : 0;
+}
 
+/* Transfer an array from the GenVar into the record's buffer.
+ * If the types match then this is a single memcpy(); otherwise
+ * the entire array is converted by a single dbPutConvertRoutine()
+ * call. NORD is updated on success.
+ */
 static long
-devGenVarInitRec(DBLINK *l, dbCommon *prec, int fldOff, int rawFldOff)
+arrGet(DevGenVarPvt p, DevGenVar gv, const void *src)
 {
-RegHead       h;
-DevGenVarPvt  p = 0;
-char        *nm = 0;
-long       rval = -1;
-dbFldDes  *fldD;
+unsigned short dbf_t = p->dbaddr.field_type;
+unsigned short dbr_t = gv->dbr_t;
+long n = GV_NELMS( gv );
+long status;
 
-	if ( VME_IO != l->type ) {
-		errlogPrintf("devGenVarInitRec(%s): link must be of type VME_IO\n", prec->name);
-		rval = S_dev_badBus;
-		goto bail;
+	if ( n > p->dbaddr.no_elements )
+		n = p->dbaddr.no_elements;
+
+	if ( dbr_t == dbf_t ) {
+		memcpy( p->dbaddr.pfield, src, n * p->dbaddr.field_size );
+		status = 0;
+	} else {
+		status = (* (dbPutConvertRoutine[dbr_t][dbf_t]))(&p->dbaddr, src, n, p->dbaddr.no_elements, 0);
 	}
 
-	if ( ! ( h = findEntry( l->value.vmeio.parm ) ) ) {
-		errlogPrintf("devGenVarInitRec(%s): no registry entry found for %s\n", prec->name, l->value.vmeio.parm);
-		rval = S_dev_noDeviceFound;
-		goto bail;
+	if ( 0 == status )
+		*p->nord_p = n;
+
+	return status;
+}
+
+/* Transfer NORD elements (but no more than the GenVar holds) from
+ * the record's buffer into the GenVar.
+ */
+static long
+arrPut(DevGenVarPvt p, DevGenVar gv, void *dst)
+{
+unsigned short dbf_t = p->dbaddr.field_type;
+unsigned short dbr_t = gv->dbr_t;
+long n = *p->nord_p;
+
+	if ( n > GV_NELMS( gv ) )
+		n = GV_NELMS( gv );
+
+	if ( dbr_t == dbf_t ) {
+		memcpy( dst, p->dbaddr.pfield, n * p->dbaddr.field_size );
+		return 0;
 	}
 
-	if ( l->value.vmeio.card >= h->n_entries ) {
-		errlogPrintf("devGenVarInitRec(%s): invalid card # %u; only up to %i supported\n", prec->name, l->value.vmeio.card, h->n_entries - 1);
-		rval = S_dev_badCard;
-		goto bail;
+	return (* (dbGetConvertRoutine[dbf_t][dbr_t]))(&p->dbaddr, dst, n, p->dbaddr.no_elements, 0);
+}
+
+/* Capacity (in bytes, including the terminating NUL) of a string
+ * GenVar: either DBR_STRING or a DBR_CHAR/DBR_UCHAR array.
+ */
+static __inline__ size_t
+strCap(DevGenVar gv)
+{
+	return GV_NELMS( gv ) * (DBR_STRING == gv->dbr_t ? MAX_STRING_SIZE : 1);
+}
+
+/* Bounded copy of a NUL-terminated string; 'dst' is always terminated */
+static __inline__ void
+strXfer(char *dst, size_t dst_sz, const char *src, size_t src_sz)
+{
+size_t n = dst_sz - 1 < src_sz ? dst_sz - 1 : src_sz;
+const char *e;
+
+	if ( (e = memchr( src, 0, n )) )
+		n = e - src;
+	memcpy( dst, src, n );
+	dst[n] = 0;
+}
+
+/* Transfer a string from the GenVar into a string field (the field
+ * size is that of stringin.VAL or lsi.VAL (SIZV))
+ */
+static long
+strGet(DevGenVarPvt p, DevGenVar gv, const void *src)
+{
+	strXfer( p->dbaddr.pfield, p->dbaddr.field_size, src, strCap( gv ) );
+	return 0;
+}
+
+static long
+strPut(DevGenVarPvt p, DevGenVar gv, void *dst)
+{
+	strXfer( dst, strCap( gv ), p->dbaddr.pfield, p->dbaddr.field_size );
+	return 0;
+}
+
+/* Reader side of DEV_GEN_VAR_OPT_SEQLOCK mode. For other GenVars
+ * these reduce to a single test.
+ */
+static __inline__ epicsUInt32
+seqReadBegin(DevGenVar gv)
+{
+epicsUInt32 seq;
+unsigned    spin = 0;
+
+	if ( ! (gv->opts & DEV_GEN_VAR_OPT_SEQLOCK) )
+		return 0;
+
+	/* odd sequence number means that the writer is busy */
+	while ( (seq = __atomic_load_n( &gv->seq, __ATOMIC_ACQUIRE )) & 1 ) {
+		if ( ++spin > 100 )
+			epicsThreadSleep( 0.0 );
 	}
+	return seq;
+}
 
-	if ( ! ( p = calloc( 1, sizeof(*p) ) ) ) {
-		errlogPrintf("devGenVarInitRec(%s): no memory for DPVT\n", prec->name);
-		rval = S_db_noMemory;
-		goto bail;
+static __inline__ int
+seqReadRetry(DevGenVar gv, epicsUInt32 seq)
+{
+	if ( ! (gv->opts & DEV_GEN_VAR_OPT_SEQLOCK) )
+		return 0;
+
+	__atomic_thread_fence( __ATOMIC_ACQUIRE );
+	return __atomic_load_n( &gv->seq, __ATOMIC_RELAXED ) != seq;
+}
+
+/* Readers need not take the GenVar's mutex */
+#define GV_LOCKLESS(gv) ( ((gv)->opts & DEV_GEN_VAR_OPT_SEQLOCK) || (gv)->snap )
+
+/* Read 'src' (the GenVar's data) into the record field */
+static __inline__ long
+rdData(DevGenVarPvt p, DevGenVar gv, const volatile void *src)
+{
+void *dst = p->dbaddr.pfield;
+
+	switch ( p->kern ) {
+		case KERN_CPY1: *(epicsUInt8 *)dst = *(const volatile epicsUInt8 *)src; return 0;
+		case KERN_CPY2: *(epicsUInt16*)dst = *(const volatile epicsUInt16*)src; return 0;
+		case KERN_CPY4: *(epicsUInt32*)dst = *(const volatile epicsUInt32*)src; return 0;
+		/* single (atomic) load; 64-bit counters need no mutex */
+		case KERN_CPY8: *(epicsUInt64*)dst = __atomic_load_n( (const volatile epicsUInt64*)src, __ATOMIC_RELAXED ); return 0;
+		case KERN_ARR : return arrGet( p, gv, (const void*)src );
+		case KERN_STR : return strGet( p, gv, (const void*)src );
+		default:
+		break;
+	}
+	return p->rd_cvt( (const void*)src, dst, &p->dbaddr );
+}
+
+/* Write the record field into 'dst' (the GenVar's data) */
+static __inline__ long
+wrData(DevGenVarPvt p, DevGenVar gv, volatile void *dst)
+{
+const void *src = p->dbaddr.pfield;
+
+	switch ( p->kern ) {
+		case KERN_CPY1: *(volatile epicsUInt8 *)dst = *(const epicsUInt8 *)src; return 0;
+		case KERN_CPY2: *(volatile epicsUInt16*)dst = *(const epicsUInt16*)src; return 0;
+		case KERN_CPY4: *(volatile epicsUInt32*)dst = *(const epicsUInt32*)src; return 0;
+		case KERN_CPY8: __atomic_store_n( (volatile epicsUInt64*)dst, *(const epicsUInt64*)src, __ATOMIC_RELAXED ); return 0;
+		case KERN_ARR : return arrPut( p, gv, (void*)dst );
+		case KERN_STR : return strPut( p, gv, (void*)dst );
+		default:
+		break;
+	}
+	return p->wr_cvt( src, (void*)dst, &p->dbaddr );
+}
+
+/* Select the transfer kernel for a record field / GenVar pair */
+static long
+selectKern(DevGenVarPvt p)
+{
+unsigned short dbf_t = p->dbaddr.field_type;
+unsigned short dbr_t = p->gv->dbr_t;
+
+	if ( dbf_t > DBF_DEVICE || dbr_t > DBR_ENUM )
+		return S_db_badDbrtype;
+
+	p->rd_cvt = (GvCvt) dbFastPutConvertRoutine[dbr_t][dbf_t];
+	p->wr_cvt = (GvCvt) dbFastGetConvertRoutine[dbf_t][dbr_t];
+
+	if ( p->nord_p ) {
+		p->kern = KERN_ARR;
+	} else if ( DBF_STRING == dbf_t && (DBR_STRING == dbr_t || (GV_NELMS( p->gv ) > 1 && (DBR_CHAR == dbr_t || DBR_UCHAR == dbr_t))) ) {
+		/* no 40-char limit of the conversion table; long strings (lsi/lso) */
+		p->kern = KERN_STR;
+	} else if ( dbr_t != dbf_t || DBR_STRING == dbr_t ) {
+		p->kern = KERN_CVT;
+	} else switch ( p->dbaddr.field_size ) {
+		case 1:  p->kern = KERN_CPY1; break;
+		case 2:  p->kern = KERN_CPY2; break;
+		case 4:  p->kern = KERN_CPY4; break;
+		case 8:  p->kern = KERN_CPY8; break;
+		default: p->kern = KERN_CVT;  break;
+	}
+	return 0;
+}
+
+long 
+devGenVarGet_nolock(dbCommon *prec)
+{
+DevGenVarPvt       p = prec->dpvt;
+DevGenVar         gv = p->gv;
+long          status;
+epicsUInt32      seq;
+epicsTimeStamp    ts;
+epicsEnum16 stat, sevr;
+SnapBuf          *sb;
+FifoCell          *c;
+epicsUInt32        g = 0;
+
+	if ( (p->flags & FLG_ASYNC) && ! prec->pact ) {
+		/* Phase 1: ask low-level code for a value; it calls
+		 * devGenVarProcComplete() once the value is available.
+		 */
+		if ( asyncQPush( gv->asyncq, prec ) ) {
+			DEV_GEN_VAR_STAT_INC( gv, n_conflict );
+			recGblRecordError(S_dev_Conflict, prec, "Asynchronous queue of GenVar full\n");
+			recGblSetSevr( prec, READ_ALARM, INVALID_ALARM );
+			return -1;
+		}
+		p->arec->n_val = 0;
+		prec->pact     = TRUE;
+		if ( gv->evt && ! (p->flags & FLG_NPOST) ) {
+			DEV_GEN_VAR_STAT_INC( gv, n_evt );
+			epicsEventSignal( gv->evt );
+		}
+		return 0;
+	}
+
+	if ( GV_FIFO_IN( gv ) ) {
+		/* Input FIFO: consume one sample per process. Disarm
+		 * before looking so that a concurrent devGenVarPush()
+		 * either sees 'armed' clear or its sample is seen below.
+		 */
+		__atomic_store_n( &gv->fifo->armed, 0, __ATOMIC_SEQ_CST );
+		if ( ! (c = fifoTake( gv->fifo )) ) {
+			/* nothing new; leave the record alone */
+			return (p->flags & FLG_NCONV) ? 2 : 0;
+		}
+		status = rdData( p, gv, c->data );
+		if ( p->nord_p && *p->nord_p > (epicsUInt32)c->n )
+			*p->nord_p = c->n;
+		ts     = c->ts;
+		stat   = c->stat;
+		sevr   = c->sevr;
+		fifoRelease( gv->fifo, c );
+		/* more samples: process again */
+		__atomic_thread_fence( __ATOMIC_SEQ_CST );
+		if ( fifoPending( gv->fifo ) && ! __atomic_exchange_n( &gv->fifo->armed, 1, __ATOMIC_SEQ_CST ) )
+			devGenVarScan( gv );
+	} else if ( (gv->opts & DEV_GEN_VAR_OPT_DIRTY)
+	            && (g = __atomic_load_n( &gv->gen, __ATOMIC_ACQUIRE )) == p->gen
+	            && menuScanI_O_Intr == prec->scan
+	            && ! (p->flags & FLG_ASYNC) ) {
+		/* Clean; somebody else on the scan-list changed. Keep the
+		 * value but re-assert the alarm (which process() resets).
+		 * Phase 2 of an asynchronous record always reads.
+		 */
+		DEV_GEN_VAR_STAT_INC( gv, n_clean );
+		recGblSetSevr( prec, GV_STS( gv )->stat, GV_STS( gv )->sevr );
+		return (p->flags & FLG_NCSUP) ? 2 : 0;
+	} else if ( gv->snap ) {
+		/* Read from the snapshot group's front copy */
+		sb     = snapPin( gv->snap );
+		status = rdData( p, gv, sb->data + gv->snap_off );
+		ts     = sb->ts;
+		stat   = sb->stat;
+		sevr   = sb->sevr;
+		snapUnpin( sb );
+		p->gen = g;
+	} else do {
+		seq = seqReadBegin( gv );
+
+		/* 'put' from outside data buffer to rec. field */
+		status = rdData( p, gv, gv->data_p );
+
+		ts   = GV_STS( gv )->ts;
+		stat = GV_STS( gv )->stat;
+		sevr = GV_STS( gv )->sevr;
+		p->gen = g;
+	} while ( seqReadRetry( gv, seq ) );
+
+	if ( (p->flags & FLG_ASYNC) ) {
+		/* phase 2: as passed back when this record was completed */
+		ts   = p->arec->ts;
+		stat = p->arec->stat;
+		sevr = p->arec->sevr;
+	}
+
+	/* Use timestamp, status and severity */
+	if ( epicsTimeEventDeviceTime == prec->tse )
+		prec->time = ts;
+
+	recGblSetSevr( prec, stat, sevr );
+
+	DEV_GEN_VAR_STAT_INC( gv, n_rd );
+
+	if ( status ) {
+		DEV_GEN_VAR_STAT_INC( gv, n_cvt_err );
+		recGblSetSevr( prec, READ_ALARM, INVALID_ALARM );
+	} else if ( (p->flags & FLG_NCONV) ) {
+		/* No conversion */
+		prec->udf = FALSE;
+		status = 2;
+	}
+
+	/* event was posted during phase 1 already */
+	if ( gv->evt && ! (p->flags & (FLG_NPOST | FLG_ASYNC)) ) {
+		DEV_GEN_VAR_STAT_INC( gv, n_evt );
+		epicsEventSignal( gv->evt );
 	}
 
-	p->gv    = h->gv + l->value.vmeio.card;
+	return status;
+}
+
+long
+devGenVarReadback_nolock(dbCommon *prec)
+{
+DevGenVarPvt       p = prec->dpvt;
+DevGenVar         gv = p->gv;
+long          status;
+
+	status = rdData( p, gv, gv->data_p );
+
+	if ( status ) {
+		recGblRecordError(status, prec, "Unable to read current value back\n");
+		recGblSetSevr(prec, READ_ALARM, MAJOR_ALARM);
+		/* Propagate stat, sevr and timestamp out to GenVar. This is normally
+		 * done by devGenVarPut but if devsup uses this routine it should
+		 * omit devGenVarPut when reading back fails.
+		 */
+		GV_STS( gv )->stat = prec->stat;
+		GV_STS( gv )->sevr = prec->sevr;
+	}
+
+	return status;
+}
+
+long
+devGenVarGet(dbCommon *prec)
+{
+DevGenVarPvt       p = prec->dpvt;
+DevGenVar         gv = p->gv;
+long          status;
+
+	if ( ! gv->mtx || GV_LOCKLESS( gv ) )
+		return devGenVarGet_nolock( prec );
+
+	devGenVarLockRaw( gv->mtx );
+
+		status = devGenVarGet_nolock( prec );
+
+	devGenVarUnlockRaw( gv->mtx );
+
+	return status;
+}
+
+long
+devGenVarPut_nolock(dbCommon *prec)
+{
+DevGenVarPvt       p = prec->dpvt;
+DevGenVar         gv = p->gv;
+long     status;
+FifoCell         *c = 0;
+unsigned           n = 1;
+int            first = 1;
+int            async = !! (p->flags & FLG_ASYNC);
+
+	if ( 0 == devGenVarPhase2( prec, gv ) ) {
+		/* phase 2 */
+		return 0;
+	}
+
+	if ( p->nord_p ) {
+		n = *p->nord_p;
+		if ( n > GV_NELMS( gv ) )
+			n = GV_NELMS( gv );
+	}
+
+	/* Claim the FIFO cell first; if the FIFO is full the record
+	 * must not enter asynchronous processing.
+	 */
+	if ( GV_FIFO_OUT( gv ) && ! (c = fifoClaim( gv->fifo )) ) {
+		recGblSetSevr( prec, WRITE_ALARM, INVALID_ALARM );
+		status = -1;
+		goto post;
+	}
+
+	/* Is asynchronous processing requested ? */
+	if ( async ) {
+		/* the oldest pending record owns the GenVar's stat/sevr */
+		first = ( 0 == gv->asyncq->n );
+		if ( asyncQPush( gv->asyncq, prec ) ) {
+			/* should not happen; the queue holds all async. records.
+			 * Any claimed cell must still be committed; write synchronously.
+			 */
+			DEV_GEN_VAR_STAT_INC( gv, n_conflict );
+			recGblRecordError(S_dev_Conflict, prec, "Asynchronous queue of GenVar full\n");
+			recGblSetSevr( prec, WRITE_ALARM, INVALID_ALARM );
+			async = 0;
+		} else {
+			/* Initiate phase 1 */
+			prec->pact = TRUE;
+		}
+	}
+
+	if ( GV_FIFO_OUT( gv ) ) {
+		c->n    = n;
+		status  = wrData( p, gv, c->data );
+	} else {
+		status = wrData( p, gv, gv->data_p );
+		devGenVarMarkDirty( gv );
+	}
+
+	DEV_GEN_VAR_STAT_INC( gv, n_wr );
+
+	if ( status ) {
+		DEV_GEN_VAR_STAT_INC( gv, n_cvt_err );
+		recGblSetSevr( prec, WRITE_ALARM, INVALID_ALARM );
+	}
+
+	if ( first ) {
+		GV_STS( gv )->stat = prec->stat;
+		GV_STS( gv )->sevr = prec->sevr;
+	}
+
+	if ( async )
+		asyncSave( p, prec, c ? (volatile void*)c->data : gv->data_p, n, status );
+
+	if ( c ) {
+		/* entries are never dropped; a failed conversion is flagged by the severity */
+		epicsTimeGetCurrent( &c->ts );
+		c->stat = prec->stat;
+		c->sevr = status ? INVALID_ALARM : prec->sevr;
+		fifoCommit( c );
+	}
+
+post:
+	if ( gv->evt && ! (p->flags & FLG_NPOST) ) {
+		DEV_GEN_VAR_STAT_INC( gv, n_evt );
+		epicsEventSignal( gv->evt );
+	}
+
+	return status;
+}
+
+long
+devGenVarPut(dbCommon *prec)
+{
+DevGenVarPvt       p = prec->dpvt;
+DevGenVar         gv = p->gv;
+long          status;
+
+	if ( ! gv->mtx )
+		return devGenVarPut_nolock( prec );
+
+	devGenVarLockRaw( gv->mtx );
+
+		status = devGenVarPut_nolock( prec );
+
+	devGenVarUnlockRaw( gv->mtx );
+
+	return status;
+}
+
+/* Value of a scalar as a double (for deadband comparison) */
+static double
+toDouble(unsigned dbr_t, const void *v)
+{
+	switch ( dbr_t ) {
+		case DBR_CHAR:   return *(const epicsInt8*)v;
+		case DBR_UCHAR:  return *(const epicsUInt8*)v;
+		case DBR_SHORT:  return *(const epicsInt16*)v;
+		case DBR_USHORT: return *(const epicsUInt16*)v;
+		case DBR_LONG:   return *(const epicsInt32*)v;
+		case DBR_ULONG:  return *(const epicsUInt32*)v;
+		case DBR_FLOAT:  return *(const epicsFloat32*)v;
+		case DBR_DOUBLE: return *(const epicsFloat64*)v;
+#ifdef DBR_INT64
+		case DBR_INT64:  return *(const epicsInt64*)v;
+		case DBR_UINT64: return *(const epicsUInt64*)v;
+#endif
+		case DBR_ENUM:   return *(const epicsEnum16*)v;
+		default:
+		break;
+	}
+	return 0.;
+}
+
+long
+devGenVarUpdate(DevGenVar p, const void *val_p, const epicsTimeStamp *ts)
+{
+size_t sz;
+int    changed;
+double v;
+const char *e;
+
+	if ( p->dbr_t > DBR_ENUM || ! p->data_p || p->snap )
+		return -1;
+
+	sz = GV_NELMS( p ) * dbValueSize( p->dbr_t );
+
+	if ( DBR_STRING == p->dbr_t && 1 == GV_NELMS( p ) ) {
+		/* 'val_p' may be a shorter string; compare/copy up to the NUL only */
+		if ( (e = memchr( val_p, 0, sz )) )
+			sz = e - (const char*)val_p + 1;
+	}
+
+	if ( (p->opts & DEV_GEN_VAR_OPT_SEQLOCK) )
+		devGenVarSeqBegin( p );
+	else
+		devGenVarLock( p );
+
+	if ( p->deadband > 0. && 1 == GV_NELMS( p ) && DBR_STRING != p->dbr_t ) {
+		v       = toDouble( p->dbr_t, val_p );
+		if ( ! p->upd_valid ) {
+			/* nothing scanned yet */
+			changed = 1;
+		} else if ( v != v || p->upd_last != p->upd_last ) {
+			/* NaN: only a transition from/to a number is a change */
+			changed = (v != v) != (p->upd_last != p->upd_last);
+		} else {
+			changed = fabs( v - p->upd_last ) > p->deadband;
+		}
+		if ( changed ) {
+			p->upd_last  = v;
+			p->upd_valid = 1;
+		}
+		memcpy( (void*)p->data_p, val_p, sz );
+	} else {
+		/* identical values (e.g., strings that rarely change) are not rewritten */
+		if ( (changed = memcmp( (void*)p->data_p, val_p, sz )) )
+			memcpy( (void*)p->data_p, val_p, sz );
+		/* nothing scanned yet */
+		if ( ! p->upd_valid ) {
+			changed      = 1;
+			p->upd_valid = 1;
+		}
+	}
+
+	if ( ts )
+		p->ts = *ts;
+
+	if ( (p->opts & DEV_GEN_VAR_OPT_SEQLOCK) )
+		devGenVarSeqEndNoMark( p );
+	else
+		devGenVarUnlock( p );
+
+	if ( ! changed ) {
+		__atomic_fetch_add( &p->n_supp, 1, __ATOMIC_RELAXED );
+		return 0;
+	}
+
+	devGenVarMarkDirty( p );
+	devGenVarScan( p );
+	return 1;
+}
+
+/* devGenVarUpdateBatch() sorts a private array of pointers */
+static int
+cmpUpdMtx(const void *a, const void *b)
+{
+size_t ma = (size_t)(*(const DevGenVarUpd*)a)->gv->mtx;
+size_t mb = (size_t)(*(const DevGenVarUpd*)b)->gv->mtx;
+
+	return ma < mb ? -1 : (ma > mb ? 1 : 0);
+}
+
+static int
+cmpUpdScan(const void *a, const void *b)
+{
+size_t sa = (size_t)(*(const DevGenVarUpd*)a)->gv->scan_p;
+size_t sb = (size_t)(*(const DevGenVarUpd*)b)->gv->scan_p;
+
+	return sa < sb ? -1 : (sa > sb ? 1 : 0);
+}
+
+/* Batches up to this size are sorted on the stack */
+#define UPD_BATCH_STACK 64
+
+long
+devGenVarUpdateBatch(DevGenVarUpd upd, int n, const epicsTimeStamp *ts)
+{
+int          i, j;
+long         rval = 0;
+DevGenVar    gv;
+DevGenVarMtx mtx;
+size_t       sz;
+DevGenVarUpd stk[UPD_BATCH_STACK];
+DevGenVarUpd *idx;
+
+	if ( n <= 0 || ! upd )
+		return -1;
+
+	if ( n <= UPD_BATCH_STACK ) {
+		idx = stk;
+	} else if ( ! (idx = malloc( n * sizeof(*idx) )) ) {
+		errlogPrintf("devGenVarUpdateBatch: no memory for %i entries\n", n);
+		return -1;
+	}
+
+	/* The caller's array is left alone; sort an array of pointers */
+	for ( i = 0; i < n; i++ )
+		idx[i] = &upd[i];
+
+	/* Group by mutex; take each one once */
+	qsort( idx, n, sizeof(*idx), cmpUpdMtx );
+
+	for ( i = 0; i < n; i = j ) {
+		mtx = idx[i]->gv->mtx;
+
+		if ( mtx )
+			devGenVarLockRaw( mtx );
+
+		for ( j = i; j < n && idx[j]->gv->mtx == mtx; j++ ) {
+			gv = idx[j]->gv;
+			if ( gv->dbr_t > DBR_ENUM || ! gv->data_p || gv->snap ) {
+				rval = -1;
+				continue;
+			}
+			sz = GV_NELMS( gv ) * dbValueSize( gv->dbr_t );
+			if ( (gv->opts & DEV_GEN_VAR_OPT_SEQLOCK) )
+				devGenVarSeqBegin( gv );
+			if ( memcmp( (void*)gv->data_p, idx[j]->val_p, sz ) || ! gv->upd_valid ) {
+				memcpy( (void*)gv->data_p, idx[j]->val_p, sz );
+				gv->upd_valid = 1;
+				devGenVarMarkDirty( gv );
+			}
+			if ( ts )
+				gv->ts = *ts;
+			if ( (gv->opts & DEV_GEN_VAR_OPT_SEQLOCK) )
+				devGenVarSeqEndNoMark( gv );
+		}
+
+		if ( mtx )
+			devGenVarUnlockRaw( mtx );
+	}
+
+	/* Group by scan-list; request each one once */
+	qsort( idx, n, sizeof(*idx), cmpUpdScan );
+
+	for ( i = 0; i < n; i = j ) {
+		for ( j = i + 1; j < n && idx[j]->gv->scan_p == idx[i]->gv->scan_p; j++ )
+			/* skip */;
+		if ( idx[i]->gv->scan_p ) {
+			devGenVarScan( idx[i]->gv );
+			if ( rval >= 0 )
+				rval++;
+		}
+	}
+
+	if ( idx != stk )
+		free( idx );
+
+	return rval;
+}
+
+/* Merge 'val' into the GenVar's integer under 'mask' with a CAS loop;
+ * the previous value is returned in *old_p (converted like a readback).
+ * 'val' and 'mask' are 64 bits wide so that a full-width write of a
+ * 64-bit GenVar clears the upper half (like the locked path, which
+ * zero-extends RVAL).
+ */
+#define MASKED_MERGE(typ) \
+	do { \
+		typ o = __atomic_load_n( (typ*)p->data_p, __ATOMIC_RELAXED ); \
+		typ n; \
+		do { \
+			n = (typ)((o & ~(typ)mask) | ((typ)val & (typ)mask)); \
+		} while ( ! __atomic_compare_exchange_n( (typ*)p->data_p, &o, n, 1, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED ) ); \
+		old = (epicsUInt32)o; \
+	} while (0)
+
+static long
+maskedMerge(DevGenVar p, epicsUInt64 val, epicsUInt64 mask, epicsUInt32 *old_p)
+{
+epicsUInt32 old;
+
+	switch ( p->dbr_t ) {
+		case DBR_CHAR:   MASKED_MERGE( epicsInt8   ); break;
+		case DBR_UCHAR:  MASKED_MERGE( epicsUInt8  ); break;
+		case DBR_SHORT:  MASKED_MERGE( epicsInt16  ); break;
+		case DBR_USHORT: MASKED_MERGE( epicsUInt16 ); break;
+		case DBR_ENUM:   MASKED_MERGE( epicsEnum16 ); break;
+		case DBR_LONG:   MASKED_MERGE( epicsInt32  ); break;
+		case DBR_ULONG:  MASKED_MERGE( epicsUInt32 ); break;
+#ifdef DBR_INT64
+		case DBR_INT64:  MASKED_MERGE( epicsInt64  ); break;
+		case DBR_UINT64: MASKED_MERGE( epicsUInt64 ); break;
+#endif
+		default:
+			return -1;
+	}
+	if ( old_p )
+		*old_p = old;
+	devGenVarMarkDirty( p );
+	return 0;
+}
+
+#undef MASKED_MERGE
+
+long
+devGenVarSetBits(DevGenVar p, epicsUInt32 bits, epicsUInt32 *old_p)
+{
+	return maskedMerge( p, bits, bits, old_p );
+}
+
+long
+devGenVarClearBits(DevGenVar p, epicsUInt32 bits, epicsUInt32 *old_p)
+{
+	return maskedMerge( p, 0, bits, old_p );
+}
+
+/* Lock-free masked write of a bo/mbbo record (DEV_GEN_VAR_OPT_ATOMIC).
+ * RETURNS: -1 if the GenVar/record must use the locked path.
+ */
+static long
+maskedPut(dbCommon *prec, epicsUInt32 val, epicsUInt32 mask, epicsUInt32 *old_p)
+{
+DevGenVarPvt       p = prec->dpvt;
+DevGenVar         gv = p->gv;
+
+	if ( ! (gv->opts & DEV_GEN_VAR_OPT_ATOMIC) || (p->flags & FLG_ASYNC) || gv->fifo || GV_NELMS( gv ) != 1 )
+		return -1;
+
+	/* no mask: write all bits (of a 64-bit GenVar, too) */
+	if ( maskedMerge( gv, val, mask ? (epicsUInt64)mask : ~(epicsUInt64)0, old_p ) )
+		return -1;
+
+	/* gv->stat/sevr are not written; that would need the lock */
+	DEV_GEN_VAR_STAT_INC( gv, n_wr );
+
+	if ( gv->evt && ! (p->flags & FLG_NPOST) ) {
+		DEV_GEN_VAR_STAT_INC( gv, n_evt );
+		epicsEventSignal( gv->evt );
+	}
+
+	return 0;
+}
+
+long
+devGenVarInitScanPvt( DevGenVar p, int n_entries )
+{
+int        i;
+IOSCANPVT *scan_p;
+
+	devGenVarInit( p, n_entries );
+
+	if ( ! (scan_p = devGenVarArenaAlloc( &scanArena, n_entries * sizeof(*scan_p), sizeof(*scan_p) )) )
+		return -1;
+
+	for ( i = 0; i < n_entries; i++ ) {
+		p[i].scan_p = scan_p + i;
+		scanIoInit( p[i].scan_p );
+	}
+	return 0;
+}
+
+
+long
+devGenVarGetIointInfo(int delFrom, dbCommon *prec, IOSCANPVT *ppvt)
+{
+DevGenVar gv = ((DevGenVarPvt)prec->dpvt)->gv;
+
+	if ( ! (gv->scan_p) )
+		return -1;
+	*ppvt = *gv->scan_p;
+	return 0;
+}
+
+/* Total time spent in devGenVarInitRec(); reported
+ * once the IOC is running.
+ */
+static double        initRecTime = 0.;
+static unsigned long initRecCnt  = 0;
+
+static DevGenVarPvt
+dpvtAlloc(DevGenVarPvt tmpl)
+{
+DevGenVarPvt  p;
+DevGenVarPvt *l;
+
+	if ( dpvtListLen == dpvtListCap ) {
+		if ( ! (l = realloc( dpvtList, (dpvtListCap ? 2*dpvtListCap : 1024) * sizeof(*l) )) )
+			return 0;
+		dpvtList     = l;
+		dpvtListCap  = dpvtListCap ? 2*dpvtListCap : 1024;
+	}
+
+	if ( (p = devGenVarArenaAlloc( dpvtCompacted ? &dpvtArena : &dpvtInitArena, sizeof(*p), sizeof(double) )) ) {
+		*p = *tmpl;
+		dpvtList[dpvtListLen++] = p;
+	}
+	return p;
+}
+
+static int
+cmpDpvt(const void *a, const void *b)
+{
+DevGenVarPvt pa = *(DevGenVarPvt*)a;
+DevGenVarPvt pb = *(DevGenVarPvt*)b;
+size_t       ka = (size_t)pa->gv->scan_p;
+size_t       kb = (size_t)pb->gv->scan_p;
+
+	if ( ka == kb ) {
+		ka = (size_t)pa->gv;
+		kb = (size_t)pb->gv;
+	}
+	return ka < kb ? -1 : ( ka > kb ? 1 : 0 );
+}
+
+/* Move all DPVTs into one contiguous block ordered by scan-list */
+static void
+dpvtCompact()
+{
+unsigned long  i, n;
+DevGenVarPvt   p;
+dbCommon      *prec;
+
+	/* drop DPVTs of records which failed initialization later on */
+	for ( i = n = 0; i < dpvtListLen; i++ ) {
+		if ( dpvtList[i]->dbaddr.precord->dpvt == dpvtList[i] )
+			dpvtList[n++] = dpvtList[i];
+	}
+	dpvtListLen = n;
+
+	qsort( dpvtList, n, sizeof(dpvtList[0]), cmpDpvt );
+
+	if ( n > 0 && ! (p = devGenVarArenaAlloc( &dpvtArena, n * sizeof(*p), DEV_GEN_VAR_CACHE_LINE )) ) {
+		/* keep using the original ones */
+		errlogPrintf("devGenVar: no memory for compacting DPVTs\n");
+		return;
+	}
+
+	for ( i = 0; i < n; i++ ) {
+		p[i]        = *dpvtList[i];
+		prec        = p[i].dbaddr.precord;
+		prec->dpvt  = &p[i];
+		dpvtList[i] = &p[i];
+	}
+
+	devGenVarArenaRelease( &dpvtInitArena );
+	dpvtCompacted = 1;
+}
+
+/* dset report(): list the records of one type */
+static long
+reportRecs(const char *recType, int interest)
+{
+unsigned long i, n = 0;
+DevGenVarPvt  p;
+DevGenVar     gv;
+dbCommon     *prec;
+
+	for ( i = 0; i < dpvtListLen; i++ ) {
+		p    = dpvtList[i];
+		gv   = p->gv;
+		prec = p->dbaddr.precord;
+		if ( prec->dpvt != p || strcmp( prec->rdes->name, recType ) )
+			continue;
+		n++;
+		if ( interest > 0 ) {
+			printf("  %-40s rd %10lu wr %10lu cvt-err %6lu evt %10lu conflict %6lu scan %10lu clean %10lu\n",
+				prec->name,
+				gv->stats.n_rd, gv->stats.n_wr, gv->stats.n_cvt_err,
+				gv->stats.n_evt, gv->stats.n_conflict, gv->stats.n_scan, gv->stats.n_clean);
+		}
+	}
+	if ( n > 0 )
+		printf("  devGenVar: %lu %s record(s)\n", n, recType);
+	return 0;
+}
+
+typedef struct StatEntry_ {
+	const char   *name;
+	int           idx;
+	unsigned long tot;
+	DevGenVar     gv;
+} StatEntry;
+
+typedef struct StatTop_ {
+	StatEntry    *tab;
+	int           n, len;
+} StatTop;
+
+static unsigned long
+statTot(DevGenVar gv)
+{
+	return gv->stats.n_rd + gv->stats.n_wr + gv->stats.n_scan;
+}
+
+/* Keep the 'n' busiest GenVars (insertion sort; 'n' is small) */
+static int
+statCollect(RegHead h, void *arg)
+{
+StatTop      *t = arg;
+int           i, j;
+unsigned long tot;
+
+	for ( i = 0; i < h->n_entries; i++ ) {
+		tot = statTot( &h->gv[i] );
+		if ( t->len == t->n && tot <= t->tab[t->len - 1].tot )
+			continue;
+		for ( j = t->len < t->n ? t->len++ : t->len - 1; j > 0 && t->tab[j-1].tot < tot; j-- )
+			t->tab[j] = t->tab[j-1];
+		t->tab[j].name = h->name;
+		t->tab[j].idx  = i;
+		t->tab[j].tot  = tot;
+		t->tab[j].gv   = &h->gv[i];
+	}
+	return 0;
+}
+
+static int
+statReset(RegHead h, void *arg)
+{
+int i;
+
+	for ( i = 0; i < h->n_entries; i++ )
+		memset( &h->gv[i].stats, 0, sizeof(h->gv[i].stats) );
+	return 0;
+}
+
+void
+devGenVarStatShow(int n, int reset)
+{
+StatTop       t;
+int           i;
+DevGenVar     gv;
+
+	if ( n <= 0 )
+		n = 10;
+
+	if ( ! (t.tab = malloc( n * sizeof(t.tab[0]) )) ) {
+		errlogPrintf("devGenVarStatShow: no memory\n");
+		return;
+	}
+	t.n   = n;
+	t.len = 0;
+
+	devGenVarRegForEach( statCollect, &t );
+
+	printf("%-32s %10s %10s %8s %10s %8s %10s %10s\n",
+		"GenVar[idx]", "Reads", "Writes", "CvtErr", "Events", "Conflict", "Scans", "Clean");
+	for ( i = 0; i < t.len; i++ ) {
+		gv = t.tab[i].gv;
+		printf("%-28s[%3i] %10lu %10lu %8lu %10lu %8lu %10lu %10lu\n",
+			t.tab[i].name, t.tab[i].idx,
+			gv->stats.n_rd, gv->stats.n_wr, gv->stats.n_cvt_err,
+			gv->stats.n_evt, gv->stats.n_conflict, gv->stats.n_scan, gv->stats.n_clean);
+	}
+
+	if ( reset )
+		devGenVarRegForEach( statReset, 0 );
+
+	free( t.tab );
+}
+
+static void
+initHook(initHookState state)
+{
+	switch ( state ) {
+		case initHookAfterInitDatabase:
+			dpvtCompact();
+			break;
+
+		case initHookAfterIocRunning:
+			if ( initRecCnt > 0 ) {
+				printf("devGenVar: %lu records initialized in %.3f ms (%.2f us/record)\n",
+					initRecCnt, initRecTime*1.0E3, initRecTime*1.0E6/(double)initRecCnt);
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+/* Equivalent of dbNameToAddr() for a field of a record we
+ * already hold -- without building and looking up the name.
+ */
+static long
+fillAddr(dbAddr *a, dbCommon *prec, dbFldDes *fldD)
+{
+	a->precord        = prec;
+	a->pfield         = (char*)prec + fldD->offset;
+	a->pfldDes        = fldD;
+	a->no_elements    = 1;
+	a->field_type     = fldD->field_type;
+	a->field_size     = fldD->size;
+	a->special        = fldD->special;
+	a->dbr_field_type = mapDBFToDBR[fldD->field_type];
+
+	if ( SPC_DBADDR == a->special && prec->rset && prec->rset->cvt_dbaddr )
+		return prec->rset->cvt_dbaddr( a );
+	return 0;
+}
+
+static long
+devGenVarInitRec(DBLINK *l, dbCommon *prec, int fldOff, int rawFldOff, epicsUInt32 *nord_p)
+{
+RegHead       h;
+DevGenVarPvtRec tmp;
+DevGenVarPvt  p = &tmp;
+long       rval = -1;
+dbFldDes  *fldD;
+epicsTimeStamp t0, t1;
+
+	epicsTimeGetCurrent( &t0 );
+
+	memset( p, 0, sizeof(*p) );
+
+	if ( VME_IO != l->type ) {
+		errlogPrintf("devGenVarInitRec(%s): link must be of type VME_IO\n", prec->name);
+		rval = S_dev_badBus;
+		goto bail;
+	}
+
+	if ( ! ( h = devGenVarRegFind( l->value.vmeio.parm ) ) && ! ( h = structMemberFind( l->value.vmeio.parm ) ) ) {
+		errlogPrintf("devGenVarInitRec(%s): no registry entry found for %s\n", prec->name, l->value.vmeio.parm);
+		rval = S_dev_noDeviceFound;
+		goto bail;
+	}
+
+	if ( l->value.vmeio.card >= h->n_entries ) {
+		errlogPrintf("devGenVarInitRec(%s): invalid card # %u; only up to %i supported\n", prec->name, l->value.vmeio.card, h->n_entries - 1);
+		rval = S_dev_badCard;
+		goto bail;
+	}
+
+	p->gv     = h->gv + l->value.vmeio.card;
+	p->nord_p = nord_p;
+	/* first read is never skipped */
+	p->gen    = p->gv->gen - 1;
+
+	p->flags = (l->value.vmeio.signal & 0xffff);
+
+	if ( rawFldOff >= 0 ) {
+		p->flags |= FLG_NCSUP;
+		if ( ( p->flags & FLG_NCONV ) ) {
+			/* no conversion; use raw field */
+			fldOff = rawFldOff;
+		}
+	} else {
+		p->flags &= ~FLG_NCONV;
+	}
+
+	if ( fldOff >= prec->rdes->no_fields ) {
+		errlogPrintf("devGenVarInitRec(%s): fldOff(%i) out of range\n", prec->name, fldOff);
+		rval = S_db_errArg;
+		goto bail;
+	}
+
+	fldD = fldOff < 0 ? prec->rdes->pvalFldDes : prec->rdes->papFldDes[fldOff];
+
+	if ( fillAddr( &p->dbaddr, prec, fldD ) ) {
+		errlogPrintf("devGenVarInitRec(%s): unable to obtain address of field %s\n", prec->name, fldD->name);
+		rval = S_db_notFound;
+		goto bail;
+	}
+
+	if ( (rval = selectKern( p )) ) {
+		errlogPrintf("devGenVarInitRec(%s): unsupported DBR/DBF type combination (%u/%u)\n", prec->name, p->gv->dbr_t, p->dbaddr.field_type);
+		goto bail;
+	}
+
+	if ( (p->flags & FLG_ASYNC) ) {
+		if ( GV_LOCKLESS( p->gv ) ) {
+			errlogPrintf("devGenVarInitRec(%s): asynchronous processing not possible with a GenVar in SEQLOCK mode or snapshot group\n", prec->name);
+			rval = S_dev_Conflict;
+			goto bail;
+		}
+		if ( p->gv->tmpl ) {
+			/* devGenVarProcComplete() is called on the template which has no queue */
+			errlogPrintf("devGenVarInitRec(%s): asynchronous processing not possible with a struct member\n", prec->name);
+			rval = S_dev_Conflict;
+			goto bail;
+		}
+		if ( ! p->gv->mtx ) {
+			/* the queue of pending records is protected by the GenVar's lock */
+			errlogPrintf("devGenVarInitRec(%s): asynchronous processing needs a GenVar with a mutex\n", prec->name);
+			rval = S_dev_Conflict;
+			goto bail;
+		}
+		if ( (rval = asyncQAttach( p->gv )) ) {
+			errlogPrintf("devGenVarInitRec(%s): no memory for asynchronous queue\n", prec->name);
+			goto bail;
+		}
+		if ( (rval = asyncAttach( p, prec )) ) {
+			errlogPrintf("devGenVarInitRec(%s): no memory for asynchronous processing\n", prec->name);
+			goto bail;
+		}
+	}
+
+	if ( ! ( prec->dpvt = dpvtAlloc( p ) ) ) {
+		errlogPrintf("devGenVarInitRec(%s): no memory for DPVT\n", prec->name);
+		rval = S_db_noMemory;
+		goto bail;
+	}
+
+	rval = 0;
+
+bail:
+	if ( rval ) {
+		prec->pact = TRUE;
+		recGblRecordError(rval, prec, "devGenVarInitRec failed\n");
+	}
+	epicsTimeGetCurrent( &t1 );
+	initRecTime += epicsTimeDiffInSeconds( &t1, &t0 );
+	initRecCnt++;
+	return rval;
+}
+
+static long
+initInpRec(DBLINK *l, dbCommon *prec, int fldOff, int rawFldOff, epicsUInt32 *nord_p)
+{
+long         status;
+DevGenVarPvt p;
+
+	if ( (status = devGenVarInitRec(l, prec, fldOff, rawFldOff, nord_p)) )
+		return status;
+
+	p = prec->dpvt;
+
+	if ( GV_FIFO_OUT( p->gv ) ) {
+		/* would consume the writes of the output records */
+		errlogPrintf("devGenVarInitInpRec(%s): input records cannot read from a GenVar with an output FIFO\n", prec->name);
+		prec->dpvt = 0;
+		prec->pact = TRUE;
+		return S_dev_Conflict;
+	}
+	return 0;
+}
+
+long
+devGenVarInitInpRec(DBLINK *l, dbCommon *prec, int fldOff, int rawFldOff)
+{
+	return initInpRec(l, prec, fldOff, rawFldOff, 0);
+}
+
+static long
+initOutRec(DBLINK *l, dbCommon *prec, int fldOff, int rawFldOff, epicsUInt32 *nord_p)
+{
+long         status;
+DevGenVarEvt evt;
+DevGenVarPvt p;
+epicsUInt32  flags;
+
+	status = devGenVarInitRec(l, prec, fldOff, rawFldOff, nord_p);
+	if ( status ) goto bail;
+
+	p = prec->dpvt;
+
+	if ( GV_LOCKLESS( p->gv ) ) {
+		errlogPrintf("devGenVarInitOutRec(%s): output records cannot write to a GenVar in SEQLOCK mode or snapshot group\n", prec->name);
+		prec->dpvt = 0;
+		prec->pact = TRUE;
+		status     = S_dev_Conflict;
+		goto bail;
+	}
+
+	if ( GV_FIFO_IN( p->gv ) ) {
+		errlogPrintf("devGenVarInitOutRec(%s): output records cannot write to a GenVar with an input FIFO\n", prec->name);
+		prec->dpvt = 0;
+		prec->pact = TRUE;
+		status     = S_dev_Conflict;
+		goto bail;
+	}
+
+	prec->udf = FALSE;
+	if ( status >= 0 )
+		recGblResetAlarms(prec);
+
+	if ( prec->pini ) {
+		/* Assume they want to write initial 'VAL' out. 
+		 * In this case we just initialize but don't read back.
+		 * return '2' for 'no-convert' so that the aoRecord
+		 * doesn't convert initial RVAL -> VAL before PINI
+		 * happens...
+		 * Do this only for records which support conversion...
+		 */
+		if ( (p->flags & FLG_NCSUP) )
+			status = 2;
+	} else {
+		/* Read current value into record */
+
+		flags = p->flags;
+
+		devGenVarLock( p->gv );
+		/* Ugly hack; we don't want to send the event
+		 * here so we temporarily set it to NULL (and
+		 * this is a plain read, not an asynchronous one)
+		 */
+		evt = p->gv->evt;
+		p->gv->evt = 0;
+		p->flags  &= ~FLG_ASYNC;
+		status     = devGenVarGet_nolock(prec);
+		p->flags  |= (flags & FLG_ASYNC);
+		p->gv->evt = evt;
+
+		devGenVarUnlock( p->gv );
+
+	}
+bail:
+	return status;
+}
+
+long 
+devGenVarInitOutRec(DBLINK *l, dbCommon *prec, int fldOff, int rawFldOff)
+{
+	return initOutRec(l, prec, fldOff, rawFldOff, 0);
+}
+
+long
+devGenVarEvtCreate(DevGenVar p)
+{
+	if ( p->evt )
+		return -1;
+
+	p->evt = epicsEventMustCreate( epicsEventEmpty );
+	return 0;
+}
+
+long
+devGenVarLockCreate(DevGenVar p)
+{
+	if ( p->mtx )
+		return -1;
+
+	p->mtx = epicsMutexMustCreate();
+	return 0;
+}
+
+
+#include <aiRecord.h>
+
+static long init_rec_ai(aiRecord *prec)
+{
+long status;
+
+	status = devGenVarInitInpRec( &prec->inp, (dbCommon*)prec, aiRecordRVAL, aiRecordVAL );
+
+	if ( status ) {
+		recGblRecordError(status, (void*)prec, "devGenVar(ai): init_record failed\n");
+		return status;
+	}
+	return 0;
+}
+
+static long read_ai(aiRecord *pai)
+{
+long status = devGenVarGet((dbCommon*)pai);
+
+	if ( 2 == status )
+		pai->udf = isnan(pai->val);
+
+	return status;
+}
+
+static long report_ai(int interest)
+{
+	return reportRecs( "ai", interest );
+}
+
+static struct {
+	long         number;
+	DEVSUPFUN    report;
+	DEVSUPFUN    init;
+	DEVSUPFUN    init_record;
+	DEVSUPFUN    get_ioint_info;
+	DEVSUPFUN    read_record;
+	DEVSUPFUN    special_linconv;
+} devAiGenVar = {
+	6,
+	report_ai,
+	NULL,
+	init_rec_ai,
+	devGenVarGetIointInfo,
+	read_ai,
+	NULL
+};
+epicsExportAddress(dset, devAiGenVar);
+
+#include <longinRecord.h>
+
+static long init_rec_li(longinRecord *prec)
+{
+long status;
+
+	status = devGenVarInitInpRec( &prec->inp, (dbCommon*)prec, -1, -1 );
+	if ( status ) {
+		recGblRecordError(status, (void*)prec, "devGenVar(longin): init_record failed\n");
+		return status;
+	}
+	return 0;
+}
+
+static long report_li(int interest)
+{
+	return reportRecs( "longin", interest );
+}
+
+static struct {
+	long         number;
+	DEVSUPFUN    report;
+	DEVSUPFUN    init;
+	DEVSUPFUN    init_record;
+	DEVSUPFUN    get_ioint_info;
+	DEVSUPFUN    read_record;
+} devLiGenVar = {
+	5,
+	report_li,
+	NULL,
+	init_rec_li,
+	devGenVarGetIointInfo,
+	devGenVarGet
+};
+epicsExportAddress(dset, devLiGenVar);
+
+#include <biRecord.h>
+
+static long init_rec_bi(biRecord *prec)
+{
+long status;
+
+	status = devGenVarInitInpRec( &prec->inp, (dbCommon*)prec, biRecordRVAL, biRecordVAL);
+	if ( status ) {
+		recGblRecordError(status, (void*)prec, "devGenVar(bi): init_record failed\n");
+		return status;
+	}
+	return 0;
+}
+
+static long read_bi(biRecord *prec)
+{
+long      status;
+
+	status = devGenVarGet( (dbCommon*)prec );
+
+	if ( status >= 0 && prec->mask )
+		prec->rval &= prec->mask;
+
+	return status;
+}
+
+static long report_bi(int interest)
+{
+	return reportRecs( "bi", interest );
+}
+
+static struct {
+	long         number;
+	DEVSUPFUN    report;
+	DEVSUPFUN    init;
+	DEVSUPFUN    init_record;
+	DEVSUPFUN    get_ioint_info;
+	DEVSUPFUN    read_record;
+} devBiGenVar = {
+	5,
+	report_bi,
+	NULL,
+	init_rec_bi,
+	devGenVarGetIointInfo,
+	read_bi
+};
+epicsExportAddress(dset, devBiGenVar);
+
+#include <mbbiRecord.h>
+
+static long init_rec_mbbi(mbbiRecord *prec)
+{
+long status;
+
+	status = devGenVarInitInpRec( &prec->inp, (dbCommon*)prec, mbbiRecordRVAL, mbbiRecordVAL);
+	if ( status ) {
+		recGblRecordError(status, (void*)prec, "devGenVar(mbbi): init_record failed\n");
+		return status;
+	}
+
+	/* helper: let nobt == 0 means all bits */
+	if ( 0 == prec->nobt ) prec->mask = -1;
+	prec->mask <<= prec->shft;
+	return 0;
+}
+
+static long read_mbbi(mbbiRecord *prec)
+{
+long      status;
+
+	status = devGenVarGet( (dbCommon*)prec );
+
+	if ( status >= 0 && prec->mask )
+		prec->rval &= prec->mask;
+
+	return status;
+}
+
+static long report_mbbi(int interest)
+{
+	return reportRecs( "mbbi", interest );
+}
+
+static struct {
+	long         number;
+	DEVSUPFUN    report;
+	DEVSUPFUN    init;
+	DEVSUPFUN    init_record;
+	DEVSUPFUN    get_ioint_info;
+	DEVSUPFUN    read_record;
+} devMbbiGenVar = {
+	5,
+	report_mbbi,
+	NULL,
+	init_rec_mbbi,
+	devGenVarGetIointInfo,
+	read_mbbi
+};
+epicsExportAddress(dset, devMbbiGenVar);
+
+#include <aoRecord.h>
+
+static long init_rec_ao(aoRecord *prec)
+{
+long status;
+
+	status = devGenVarInitOutRec( &prec->out, (dbCommon*)prec, aoRecordRVAL, aoRecordVAL );
+
+	if ( status && 2 != status ) {
+		recGblRecordError(status, (void*)prec, "devGenVar(ao): init_record failed\n");
+	}
+	return status;
+}
+
+static long report_ao(int interest)
+{
+	return reportRecs( "ao", interest );
+}
+
+static struct {
+	long         number;
+	DEVSUPFUN    report;
+	DEVSUPFUN    init;
+	DEVSUPFUN    init_record;
+	DEVSUPFUN    get_ioint_info;
+	DEVSUPFUN    write_record;
+	DEVSUPFUN    special_linconv;
+} devAoGenVar = {
+	6,
+	report_ao,
+	NULL,
+	init_rec_ao,
+	devGenVarGetIointInfo,
+	devGenVarPut,
+	NULL
+};
+epicsExportAddress(dset, devAoGenVar);
+
+
+#include <longoutRecord.h>
+
+static long init_rec_lo(longoutRecord *prec)
+{
+long status;
+
+	status = devGenVarInitOutRec( &prec->out, (dbCommon*)prec, -1, -1 );
+
+	if ( status && 2 != status ) {
+		recGblRecordError(status, (void*)prec, "devGenVar(longout): init_record failed\n");
+	}
+
+	return status;
+}
+
+static long report_lo(int interest)
+{
+	return reportRecs( "longout", interest );
+}
+
+static struct {
+	long         number;
+	DEVSUPFUN    report;
+	DEVSUPFUN    init;
+	DEVSUPFUN    init_record;
+	DEVSUPFUN    get_ioint_info;
+	DEVSUPFUN    write_record;
+} devLoGenVar = {
+	5,
+	report_lo,
+	NULL,
+	init_rec_lo,
+	devGenVarGetIointInfo,
+	devGenVarPut
+};
+epicsExportAddress(dset, devLoGenVar);
+
+#include <boRecord.h>
+
+/* A masked write merges into the current value of *data_p which a
+ * GenVar with a FIFO never updates; refuse partial masks there.
+ */
+static long
+maskedFifoCheck(dbCommon *prec, epicsUInt32 mask)
+{
+DevGenVarPvt p = prec->dpvt;
+
+	if ( p && p->gv->fifo && mask && 0xffffffff != mask ) {
+		errlogPrintf("devGenVar(%s): a MASK (or NOBT) cannot be used with a GenVar that has a FIFO\n", prec->name);
+		prec->dpvt = 0;
+		prec->pact = TRUE;
+		return S_dev_Conflict;
+	}
+	return 0;
+}
+
+static long init_rec_bo(boRecord *prec)
+{
+long status;
+
+	status = devGenVarInitOutRec( &prec->out, (dbCommon*)prec, boRecordRVAL, -1 );
+
+	if ( status && 2 != status ) {
+		recGblRecordError(status, (void*)prec, "devGenVar(bo): init_record failed\n");
+		return status;
+	}
+
+	if ( maskedFifoCheck( (dbCommon*)prec, prec->mask ) )
+		return S_dev_Conflict;
+
+	/* Fixup the status. We don't support non-conversion in this
+	 * devsup module but the bo record by itself does
+	 */
+	if ( prec->pini && 0 == status )
+		status = 2;
+		
+	if ( 0 == status ) {
+		/* boRecord conversion IMO doesn't convert MASK back
+		 * correctly...
+		 */
+		if ( prec->mask )
+			prec->rval &=  prec->mask;
+	}
+
+	return status;
+}
+
+static long write_bo(boRecord *prec)
+{
+long status;
+DevGenVarPvt       p = prec->dpvt;
+DevGenVar         gv = p->gv;
+epicsUInt32 rv;
+
+	if ( 0 == maskedPut( (dbCommon*)prec, prec->rval, prec->mask, &rv ) ) {
+		if ( prec->mask )
+			prec->rval = (rv & ~prec->mask) | (prec->rval & prec->mask);
+		return 0;
+	}
+
+	devGenVarLock( gv );
+
+	if ( 0 == devGenVarPhase2( (dbCommon*)prec, gv ) ) {
+		/* it was phase 2 */
+		devGenVarUnlock( gv );
+		return 0;
+	}
+
+	if ( prec->mask ) {
+		/* Read value back into RVAL (caching original value) */
+		rv = prec->rval;
+
+		status = devGenVarReadback_nolock( (dbCommon*)prec );
+
+		if ( status )
+			goto bail;
+
+		prec->rval &= ~prec->mask;
+		prec->rval |= (rv & prec->mask);
+	}
+
+	status = devGenVarPut_nolock( (dbCommon*)prec );
+
+bail:
+
+	devGenVarUnlock( gv );
+
+	return status;
+}
+
+static long report_bo(int interest)
+{
+	return reportRecs( "bo", interest );
+}
+
+static struct {
+	long         number;
+	DEVSUPFUN    report;
+	DEVSUPFUN    init;
+	DEVSUPFUN    init_record;
+	DEVSUPFUN    get_ioint_info;
+	DEVSUPFUN    write_record;
+} devBoGenVar = {
+	5,
+	report_bo,
+	NULL,
+	init_rec_bo,
+	devGenVarGetIointInfo,
+	write_bo
+};
+epicsExportAddress(dset, devBoGenVar);
+
+#include <mbboRecord.h>
+
+static long init_rec_mbbo(mbboRecord *prec)
+{
+long status;
+
+	status = devGenVarInitOutRec( &prec->out, (dbCommon*)prec, mbboRecordRVAL, -1 );
+
+	if ( status && 2 != status ) {
+		recGblRecordError(status, (void*)prec, "devGenVar(mbbo): init_record failed\n");
+		return status;
+	}
+
+	/* Fixup the status. We don't support non-conversion in this
+	 * devsup module but the bo record by itself does
+	 */
+	if ( prec->pini && 0 == status )
+		status = 2;
+		
+	/* helper: let nobt == 0 means all bits */
+	if ( 0 == prec->nobt )
+		prec->mask = -1;
+
+	prec->mask <<= prec->shft;
 
-	p->flags = (l->value.vmeio.signal & 0xffff);
+	if ( maskedFifoCheck( (dbCommon*)prec, prec->mask ) )
+		return S_dev_Conflict;
 
-	if ( rawFldOff >= 0 ) {
-		p->flags |= FLG_NCSUP;
-		if ( ( p->flags & FLG_NCONV ) ) {
-			/* no conversion; use raw field */
-			fldOff = rawFldOff;
-		}
-	} else {
-		p->flags &= ~FLG_NCONV;
-	}
+	prec->rbv = prec->rval;
 
-	if ( fldOff >= prec->rdes->no_fields ) {
-		errlogPrintf("devGenVarInitRec(%s): fldOff(%i) out of range\n", prec->name, fldOff);
-		rval = S_db_errArg;
-		goto bail;
+	if ( 0 == status ) {
+		/* mbboRecord conversion IMO doesn't convert MASK back
+		 * correctly...
+		 */
+		if ( prec->mask )
+			prec->rval &=  prec->mask;
 	}
 
-	fldD = fldOff < 0 ? prec->rdes->pvalFldDes : prec->rdes->papFldDes[fldOff];
 
-	if ( ! (nm = malloc(strlen(prec->name) + 1 + strlen(fldD->name) + 1 )) ) {
-		errlogPrintf("devGenVarInitRec(%s): no memory\n", prec->name);
-		rval = S_db_noMemory;
-		goto bail;
-	}
+	return status;
+}
 
-	strcpy(nm, prec->name);
-	strcat(nm, ".");
-	strcat(nm, fldD->name);
+static long write_mbbo(mbboRecord *prec)
+{
+long status;
+DevGenVarPvt       p = prec->dpvt;
+DevGenVar         gv = p->gv;
+epicsUInt32 rv;
 
-	if ( dbNameToAddr(nm, &p->dbaddr) ) {
-		errlogPrintf("devGenVarInitRec(%s): dbNameToAddr() failure\n", prec->name);
-		rval = S_db_notFound;
-		goto bail;
+	if ( 0 == maskedPut( (dbCommon*)prec, prec->rval, prec->mask, &rv ) ) {
+		/* RBV holds the value before the merge, as below */
+		prec->rbv  = rv;
+		prec->rval = (rv & ~prec->mask) | (prec->rval & prec->mask);
+		return 0;
 	}
 
-	prec->dpvt = p;
-	p    = 0;
-	rval = 0;
+	devGenVarLock( gv );
 
-bail:
-	free ( p  );
-	free ( nm );
-	if ( rval ) {
-		prec->pact = TRUE;
-		recGblRecordError(rval, prec, "devGenVarInitRec failed\n");
+	if ( 0 == devGenVarPhase2( (dbCommon*)prec, gv ) ) {
+		/* it was phase 2 */
+		devGenVarUnlock( gv );
+		return 0;
 	}
-	return rval;
-}
 
-long
-devGenVarInitInpRec(DBLINK *l, dbCommon *prec, int fldOff, int rawFldOff)
-{
-	return devGenVarInitRec(l, prec, fldOff, rawFldOff);
-}
+	/* Read value back into RVAL (caching original value) */
+	rv = prec->rval;
 
-long 
-devGenVarInitOutRec(DBLINK *l, dbCommon *prec, int fldOff, int rawFldOff)
-{
-long         status;
-DevGenVarEvt evt;
-DevGenVarPvt p;
+	status = devGenVarReadback_nolock( (dbCommon*)prec );
 
-	status = devGenVarInitRec(l, prec, fldOff, rawFldOff);
-	if ( status ) goto bail;
+	if ( 0 == status ) {
 
-	p = prec->dpvt;
+		prec->rbv = prec->rval;
 
-	prec->udf = FALSE;
-	if ( status >= 0 )
-		recGblResetAlarms(prec);
+		prec->rval &= ~prec->mask;
+		prec->rval |= (rv & prec->mask);
 
-	if ( prec->pini ) {
-		/* Assume they want to write initial 'VAL' out. 
-		 * In this case we just initialize but don't read back.
-		 * return '2' for 'no-convert' so that the aoRecord
-		 * doesn't convert initial RVAL -> VAL before PINI
-		 * happens...
-		 * Do this only for records which support conversion...
-		 */
-		if ( (p->flags & FLG_NCSUP) )
-			status = 2;
-	} else {
-		/* Read current value into record */
+		status = devGenVarPut_nolock( (dbCommon*)prec );
 
-		devGenVarLock( p->gv );
-		/* Ugly hack; we don't want to send the event
-		 * here so we temporarily set it to NULL
-		 */
-		evt = p->gv->evt;
-		p->gv->evt = 0;
-		status     = devGenVarGet_nolock(prec);
-		p->gv->evt = evt;
+	}
 
-		devGenVarUnlock( p->gv );
+	devGenVarUnlock( gv );
 
-	}
-bail:
 	return status;
 }
 
-long
-devGenVarEvtCreate(DevGenVar p)
+static long report_mbbo(int interest)
 {
-	if ( p->evt )
-		return -1;
-
-	p->evt = epicsEventMustCreate( epicsEventEmpty );
-	return 0;
+	return reportRecs( "mbbo", interest );
 }
 
-long
-devGenVarLockCreate(DevGenVar p)
-{
-	if ( p->mtx )
-		return -1;
-
-	p->mtx = epicsMutexMustCreate();
-	return 0;
-}
+static struct {
+	long         number;
+	DEVSUPFUN    report;
+	DEVSUPFUN    init;
+	DEVSUPFUN    init_record;
+	DEVSUPFUN    get_ioint_info;
+	DEVSUPFUN    write_record;
+} devMbboGenVar = {
+	5,
+	report_mbbo,
+	NULL,
+	init_rec_mbbo,
+	devGenVarGetIointInfo,
+	write_mbbo
+};
+epicsExportAddress(dset, devMbboGenVar);
 
+#ifdef DBR_INT64
+/* 64-bit integer records (EPICS 3.16 and later) */
 
-#include <aiRecord.h>
+#include <int64inRecord.h>
 
-static long init_rec_ai(aiRecord *prec)
+static long init_rec_i64i(int64inRecord *prec)
 {
 long status;
 
-	status = devGenVarInitInpRec( &prec->inp, (dbCommon*)prec, aiRecordRVAL, aiRecordVAL );
-
+	status = devGenVarInitInpRec( &prec->inp, (dbCommon*)prec, -1, -1 );
 	if ( status ) {
-		recGblRecordError(status, (void*)prec, "devGenVar(ai): init_record failed\n");
+		recGblRecordError(status, (void*)prec, "devGenVar(int64in): init_record failed\n");
 		return status;
 	}
 	return 0;
 }
 
-static long read_ai(aiRecord *pai)
+static long report_i64i(int interest)
 {
-long status = devGenVarGet((dbCommon*)pai);
+	return reportRecs( "int64in", interest );
+}
 
-	if ( 2 == status )
-		pai->udf = isnan(pai->val);
+static struct {
+	long         number;
+	DEVSUPFUN    report;
+	DEVSUPFUN    init;
+	DEVSUPFUN    init_record;
+	DEVSUPFUN    get_ioint_info;
+	DEVSUPFUN    read_record;
+} devI64iGenVar = {
+	5,
+	report_i64i,
+	NULL,
+	init_rec_i64i,
+	devGenVarGetIointInfo,
+	devGenVarGet
+};
+epicsExportAddress(dset, devI64iGenVar);
+
+#include <int64outRecord.h>
+
+static long init_rec_i64o(int64outRecord *prec)
+{
+long status;
+
+	status = devGenVarInitOutRec( &prec->out, (dbCommon*)prec, -1, -1 );
+
+	if ( status && 2 != status ) {
+		recGblRecordError(status, (void*)prec, "devGenVar(int64out): init_record failed\n");
+	}
 
 	return status;
 }
 
+static long report_i64o(int interest)
+{
+	return reportRecs( "int64out", interest );
+}
+
 static struct {
 	long         number;
 	DEVSUPFUN    report;
 	DEVSUPFUN    init;
 	DEVSUPFUN    init_record;
 	DEVSUPFUN    get_ioint_info;
-	DEVSUPFUN    read_record;
-	DEVSUPFUN    special_linconv;
-} devAiGenVar = {
-	6,
-	NULL,
+	DEVSUPFUN    write_record;
+} devI64oGenVar = {
+	5,
+	report_i64o,
 	NULL,
-	init_rec_ai,
+	init_rec_i64o,
 	devGenVarGetIointInfo,
-	read_ai,
-	NULL
+	devGenVarPut
 };
-epicsExportAddress(dset, devAiGenVar);
+epicsExportAddress(dset, devI64oGenVar);
+#endif
 
-#include <longinRecord.h>
+/* Array records. The GenVar's 'n_elms' gives the number of elements
+ * in *data_p; NORD is set to the number of elements transferred.
+ */
 
-static long init_rec_li(longinRecord *prec)
+static long read_arr(dbCommon *prec)
+{
+long status = devGenVarGet( prec );
+
+	if ( 0 == status )
+		prec->udf = FALSE;
+
+	return status;
+}
+
+#include <waveformRecord.h>
+
+static long init_rec_wf(waveformRecord *prec)
 {
 long status;
 
-	status = devGenVarInitInpRec( &prec->inp, (dbCommon*)prec, -1, -1 );
+	status = initInpRec( &prec->inp, (dbCommon*)prec, -1, -1, &prec->nord );
 	if ( status ) {
-		recGblRecordError(status, (void*)prec, "devGenVar(longin): init_record failed\n");
+		recGblRecordError(status, (void*)prec, "devGenVar(waveform): init_record failed\n");
 		return status;
 	}
 	return 0;
 }
 
+static long report_wf(int interest)
+{
+	return reportRecs( "waveform", interest );
+}
+
 static struct {
 	long         number;
 	DEVSUPFUN    report;
@@ -581,45 +2857,40 @@ static struct {
 	DEVSUPFUN    init_record;
 	DEVSUPFUN    get_ioint_info;
 	DEVSUPFUN    read_record;
-} devLiGenVar = {
+} devWfGenVar = {
 	5,
+	report_wf,
 	NULL,
-	NULL,
-	init_rec_li,
+	init_rec_wf,
 	devGenVarGetIointInfo,
-	devGenVarGet
+	read_arr
 };
-epicsExportAddress(dset, devLiGenVar);
+epicsExportAddress(dset, devWfGenVar);
 
-#include <biRecord.h>
+#include <aaiRecord.h>
 
-static long init_rec_bi(biRecord *prec)
+static long init_rec_aai(aaiRecord *prec)
 {
 long status;
 
-	status = devGenVarInitInpRec( &prec->inp, (dbCommon*)prec, biRecordRVAL, biRecordVAL);
+	/* Older versions of aai record support expect devsup to allocate BPTR */
+	if ( ! prec->bptr ) {
+		if ( prec->nelm <= 0 )
+			prec->nelm = 1;
+		prec->bptr = callocMustSucceed( prec->nelm, dbValueSize( prec->ftvl ), "devGenVar(aai): no memory for BPTR" );
+	}
+
+	status = initInpRec( &prec->inp, (dbCommon*)prec, -1, -1, &prec->nord );
 	if ( status ) {
-		recGblRecordError(status, (void*)prec, "devGenVar(bi): init_record failed\n");
+		recGblRecordError(status, (void*)prec, "devGenVar(aai): init_record failed\n");
 		return status;
 	}
 	return 0;
 }
 
-static long read_bi(biRecord *prec)
+static long report_aai(int interest)
 {
-DevGenVar gv = ((DevGenVarPvt)prec->dpvt)->gv;
-long      status;
-
-	devGenVarLock( gv );
-
-	status = devGenVarGet_nolock( (dbCommon*)prec );
-
-	if ( status >= 0 && prec->mask )
-		prec->rval &= prec->mask;
-		
-	devGenVarUnlock( gv );
-
-	return status;
+	return reportRecs( "aai", interest );
 }
 
 static struct {
@@ -629,49 +2900,75 @@ static struct {
 	DEVSUPFUN    init_record;
 	DEVSUPFUN    get_ioint_info;
 	DEVSUPFUN    read_record;
-} devBiGenVar = {
+} devAaiGenVar = {
 	5,
+	report_aai,
 	NULL,
-	NULL,
-	init_rec_bi,
+	init_rec_aai,
 	devGenVarGetIointInfo,
-	read_bi
+	read_arr
 };
-epicsExportAddress(dset, devBiGenVar);
+epicsExportAddress(dset, devAaiGenVar);
 
-#include <mbbiRecord.h>
+#include <aaoRecord.h>
 
-static long init_rec_mbbi(mbbiRecord *prec)
+static long init_rec_aao(aaoRecord *prec)
 {
 long status;
 
-	status = devGenVarInitInpRec( &prec->inp, (dbCommon*)prec, mbbiRecordRVAL, mbbiRecordVAL);
-	if ( status ) {
-		recGblRecordError(status, (void*)prec, "devGenVar(mbbi): init_record failed\n");
-		return status;
+	/* Older versions of aao record support expect devsup to allocate BPTR */
+	if ( ! prec->bptr ) {
+		if ( prec->nelm <= 0 )
+			prec->nelm = 1;
+		prec->bptr = callocMustSucceed( prec->nelm, dbValueSize( prec->ftvl ), "devGenVar(aao): no memory for BPTR" );
 	}
 
-	/* helper: let nobt == 0 means all bits */
-	if ( 0 == prec->nobt ) prec->mask = -1;
-	prec->mask <<= prec->shft;
-	return 0;
+	status = initOutRec( &prec->out, (dbCommon*)prec, -1, -1, &prec->nord );
+	if ( status && 2 != status ) {
+		recGblRecordError(status, (void*)prec, "devGenVar(aao): init_record failed\n");
+	}
+	return status;
 }
 
-static long read_mbbi(mbbiRecord *prec)
+static long report_aao(int interest)
 {
-DevGenVar gv = ((DevGenVarPvt)prec->dpvt)->gv;
-long      status;
+	return reportRecs( "aao", interest );
+}
 
-	devGenVarLock( gv );
+static struct {
+	long         number;
+	DEVSUPFUN    report;
+	DEVSUPFUN    init;
+	DEVSUPFUN    init_record;
+	DEVSUPFUN    get_ioint_info;
+	DEVSUPFUN    write_record;
+} devAaoGenVar = {
+	5,
+	report_aao,
+	NULL,
+	init_rec_aao,
+	devGenVarGetIointInfo,
+	devGenVarPut
+};
+epicsExportAddress(dset, devAaoGenVar);
 
-	status = devGenVarGet_nolock( (dbCommon*)prec );
+#include <stringinRecord.h>
 
-	if ( status >= 0 && prec->mask )
-		prec->rval &= prec->mask;
+static long init_rec_si(stringinRecord *prec)
+{
+long status;
 
-	devGenVarUnlock( gv );
+	status = devGenVarInitInpRec( &prec->inp, (dbCommon*)prec, -1, -1 );
+	if ( status ) {
+		recGblRecordError(status, (void*)prec, "devGenVar(stringin): init_record failed\n");
+		return status;
+	}
+	return 0;
+}
 
-	return status;
+static long report_si(int interest)
+{
+	return reportRecs( "stringin", interest );
 }
 
 static struct {
@@ -681,30 +2978,36 @@ static struct {
 	DEVSUPFUN    init_record;
 	DEVSUPFUN    get_ioint_info;
 	DEVSUPFUN    read_record;
-} devMbbiGenVar = {
+} devSiGenVar = {
 	5,
+	report_si,
 	NULL,
-	NULL,
-	init_rec_mbbi,
+	init_rec_si,
 	devGenVarGetIointInfo,
-	read_mbbi
+	devGenVarGet
 };
-epicsExportAddress(dset, devMbbiGenVar);
+epicsExportAddress(dset, devSiGenVar);
 
-#include <aoRecord.h>
+#include <stringoutRecord.h>
 
-static long init_rec_ao(aoRecord *prec)
+static long init_rec_so(stringoutRecord *prec)
 {
 long status;
 
-	status = devGenVarInitOutRec( &prec->out, (dbCommon*)prec, aoRecordRVAL, aoRecordVAL );
+	status = devGenVarInitOutRec( &prec->out, (dbCommon*)prec, -1, -1 );
 
 	if ( status && 2 != status ) {
-		recGblRecordError(status, (void*)prec, "devGenVar(ao): init_record failed\n");
+		recGblRecordError(status, (void*)prec, "devGenVar(stringout): init_record failed\n");
 	}
+
 	return status;
 }
 
+static long report_so(int interest)
+{
+	return reportRecs( "stringout", interest );
+}
+
 static struct {
 	long         number;
 	DEVSUPFUN    report;
@@ -712,116 +3015,87 @@ static struct {
 	DEVSUPFUN    init_record;
 	DEVSUPFUN    get_ioint_info;
 	DEVSUPFUN    write_record;
-	DEVSUPFUN    special_linconv;
-} devAoGenVar = {
-	6,
-	NULL,
+} devSoGenVar = {
+	5,
+	report_so,
 	NULL,
-	init_rec_ao,
+	init_rec_so,
 	devGenVarGetIointInfo,
-	devGenVarPut,
-	NULL
+	devGenVarPut
 };
-epicsExportAddress(dset, devAoGenVar);
+epicsExportAddress(dset, devSoGenVar);
 
+#if defined(EPICS_VERSION_INT) && EPICS_VERSION_INT >= VERSION_INT(3,15,0,2)
+/* Long-string records (EPICS 3.15 and later); VAL holds SIZV chars */
 
-#include <longoutRecord.h>
+#include <lsiRecord.h>
 
-static long init_rec_lo(longoutRecord *prec)
+static long init_rec_lsi(lsiRecord *prec)
 {
 long status;
 
-	status = devGenVarInitOutRec( &prec->out, (dbCommon*)prec, -1, -1 );
-
-	if ( status && 2 != status ) {
-		recGblRecordError(status, (void*)prec, "devGenVar(longout): init_record failed\n");
+	status = devGenVarInitInpRec( &prec->inp, (dbCommon*)prec, -1, -1 );
+	if ( status ) {
+		recGblRecordError(status, (void*)prec, "devGenVar(lsi): init_record failed\n");
+		return status;
 	}
+	return 0;
+}
+
+static long read_lsi(lsiRecord *prec)
+{
+long status;
 
+	status = devGenVarGet( (dbCommon*)prec );
+	/* LEN includes the NUL */
+	prec->len = strlen( prec->val ) + 1;
 	return status;
 }
 
+static long report_lsi(int interest)
+{
+	return reportRecs( "lsi", interest );
+}
+
 static struct {
 	long         number;
 	DEVSUPFUN    report;
 	DEVSUPFUN    init;
 	DEVSUPFUN    init_record;
 	DEVSUPFUN    get_ioint_info;
-	DEVSUPFUN    write_record;
-} devLoGenVar = {
+	DEVSUPFUN    read_record;
+} devLsiGenVar = {
 	5,
+	report_lsi,
 	NULL,
-	NULL,
-	init_rec_lo,
+	init_rec_lsi,
 	devGenVarGetIointInfo,
-	devGenVarPut
+	read_lsi
 };
-epicsExportAddress(dset, devLoGenVar);
+epicsExportAddress(dset, devLsiGenVar);
 
-#include <boRecord.h>
+#include <lsoRecord.h>
 
-static long init_rec_bo(boRecord *prec)
+static long init_rec_lso(lsoRecord *prec)
 {
 long status;
 
-	status = devGenVarInitOutRec( &prec->out, (dbCommon*)prec, boRecordRVAL, -1 );
+	status = devGenVarInitOutRec( &prec->out, (dbCommon*)prec, -1, -1 );
 
 	if ( status && 2 != status ) {
-		recGblRecordError(status, (void*)prec, "devGenVar(bo): init_record failed\n");
+		recGblRecordError(status, (void*)prec, "devGenVar(lso): init_record failed\n");
 		return status;
 	}
 
-	/* Fixup the status. We don't support non-conversion in this
-	 * devsup module but the bo record by itself does
-	 */
-	if ( prec->pini && 0 == status )
-		status = 2;
-		
-	if ( 0 == status ) {
-		/* boRecord conversion IMO doesn't convert MASK back
-		 * correctly...
-		 */
-		if ( prec->mask )
-			prec->rval &=  prec->mask;
-	}
+	if ( 0 == status )
+		prec->len = strlen( prec->val ) + 1;
 
 	return status;
 }
 
-static long write_bo(boRecord *prec)
+static long report_lso(int interest)
 {
-long status;
-DevGenVarPvt       p = prec->dpvt;
-DevGenVar         gv = p->gv;
-epicsUInt32 rv;
-
-	devGenVarLock( gv );
-
-	if ( 0 == devGenVarPhase2( (dbCommon*)prec, gv ) ) {
-		/* it was phase 2 */
-		devGenVarUnlock( gv );
-		return 0;
-	}
-
-	if ( prec->mask ) {
-		/* Read value back into RVAL (caching original value) */
-		rv = prec->rval;
-
-		status = devGenVarReadback_nolock( (dbCommon*)prec );
-
-		if ( status )
-			goto bail;
-
-		prec->rval &= ~prec->mask;
-		prec->rval |= (rv & prec->mask);
-	}
-
-	status = devGenVarPut_nolock( (dbCommon*)prec );
-
-bail:
-
-	devGenVarUnlock( gv );
-
-	return status;
+	return reportRecs( "lso", interest );
 }
 
 static struct {
@@ -831,132 +3105,206 @@ static struct {
 	DEVSUPFUN    init_record;
 	DEVSUPFUN    get_ioint_info;
 	DEVSUPFUN    write_record;
-} devBoGenVar = {
+} devLsoGenVar = {
 	5,
+	report_lso,
 	NULL,
-	NULL,
-	init_rec_bo,
+	init_rec_lso,
 	devGenVarGetIointInfo,
-	write_bo
+	devGenVarPut
 };
-epicsExportAddress(dset, devBoGenVar);
-
-#include <mbboRecord.h>
+epicsExportAddress(dset, devLsoGenVar);
+#endif
 
-static long init_rec_mbbo(mbboRecord *prec)
-{
-long status;
+static const iocshArg devGenVarConfigArg1 = {
+	name:	"ld_table_size",
+	type:   iocshArgInt,
+};
 
-	status = devGenVarInitOutRec( &prec->out, (dbCommon*)prec, mbboRecordRVAL, -1 );
+static const iocshArg *devGenVarConfigArgs[] = {
+	&devGenVarConfigArg1,
+};
 
-	if ( status && 2 != status ) {
-		recGblRecordError(status, (void*)prec, "devGenVar(mbbo): init_record failed\n");
-		return status;
-	}
+static iocshFuncDef devGenVarConfigDef = {
+	name: "devGenVarConfig",
+	nargs: sizeof(devGenVarConfigArgs)/sizeof(devGenVarConfigArgs[0]),
+	arg:   devGenVarConfigArgs,
+};
 
-	/* Fixup the status. We don't support non-conversion in this
-	 * devsup module but the bo record by itself does
-	 */
-	if ( prec->pini && 0 == status )
-		status = 2;
-		
-	/* helper: let nobt == 0 means all bits */
-	if ( 0 == prec->nobt )
-		prec->mask = -1;
+static void 
+devGenVarConfigCall(const iocshArgBuf *argBuf)
+{
+	devGenVarConfig( argBuf->ival );
+}
 
-	prec->mask <<= prec->shft;
+static const iocshArg devGenVarScanRateArg1 = {
+	name:	"registry_name",
+	type:   iocshArgString,
+};
 
-	prec->rbv = prec->rval;
+static const iocshArg devGenVarScanRateArg2 = {
+	name:	"max_rate_hz",
+	type:   iocshArgDouble,
+};
 
-	if ( 0 == status ) {
-		/* mbboRecord conversion IMO doesn't convert MASK back
-		 * correctly...
-		 */
-		if ( prec->mask )
-			prec->rval &=  prec->mask;
-	}
+static const iocshArg *devGenVarScanRateArgs[] = {
+	&devGenVarScanRateArg1,
+	&devGenVarScanRateArg2,
+};
 
+static iocshFuncDef devGenVarScanRateDef = {
+	name: "devGenVarScanRate",
+	nargs: sizeof(devGenVarScanRateArgs)/sizeof(devGenVarScanRateArgs[0]),
+	arg:   devGenVarScanRateArgs,
+};
 
-	return status;
+static void 
+devGenVarScanRateCall(const iocshArgBuf *argBuf)
+{
+	devGenVarScanRate( argBuf[0].sval, argBuf[1].dval );
 }
 
-static long write_mbbo(mbboRecord *prec)
+static iocshFuncDef devGenVarScanRateShowDef = {
+	name: "devGenVarScanRateShow",
+	nargs: 0,
+	arg:   0,
+};
+
+static void 
+devGenVarScanRateShowCall(const iocshArgBuf *argBuf)
 {
-long status;
-DevGenVarPvt       p = prec->dpvt;
-DevGenVar         gv = p->gv;
-epicsUInt32 rv;
+	devGenVarScanRateShow();
+}
 
-	devGenVarLock( gv );
+static const iocshArg devGenVarRegShowArg1 = {
+	name:	"level",
+	type:   iocshArgInt,
+};
 
-	if ( 0 == devGenVarPhase2( (dbCommon*)prec, gv ) ) {
-		/* it was phase 2 */
-		devGenVarUnlock( gv );
-		return 0;
-	}
+static const iocshArg *devGenVarRegShowArgs[] = {
+	&devGenVarRegShowArg1,
+};
 
-	/* Read value back into RVAL (caching original value) */
-	rv = prec->rval;
+static iocshFuncDef devGenVarRegShowDef = {
+	name: "devGenVarRegShow",
+	nargs: sizeof(devGenVarRegShowArgs)/sizeof(devGenVarRegShowArgs[0]),
+	arg:   devGenVarRegShowArgs,
+};
 
-	status = devGenVarReadback_nolock( (dbCommon*)prec );
+static void 
+devGenVarRegShowCall(const iocshArgBuf *argBuf)
+{
+	devGenVarRegShow( argBuf->ival );
+}
 
-	if ( 0 == status ) {
+static const iocshArg devGenVarArenaShowArg1 = {
+	name:	"level",
+	type:   iocshArgInt,
+};
 
-		prec->rbv = prec->rval;
+static const iocshArg *devGenVarArenaShowArgs[] = {
+	&devGenVarArenaShowArg1,
+};
 
-		prec->rval &= ~prec->mask;
-		prec->rval |= (rv & prec->mask);
+static iocshFuncDef devGenVarArenaShowDef = {
+	name: "devGenVarArenaShow",
+	nargs: sizeof(devGenVarArenaShowArgs)/sizeof(devGenVarArenaShowArgs[0]),
+	arg:   devGenVarArenaShowArgs,
+};
 
-		status = devGenVarPut_nolock( (dbCommon*)prec );
+static void 
+devGenVarArenaShowCall(const iocshArgBuf *argBuf)
+{
+	devGenVarArenaShow( argBuf->ival );
+}
 
-	}
+static const iocshArg devGenVarStatShowArg1 = {
+	name:	"n_top",
+	type:   iocshArgInt,
+};
 
-	devGenVarUnlock( gv );
+static const iocshArg devGenVarStatShowArg2 = {
+	name:	"reset",
+	type:   iocshArgInt,
+};
 
-	return status;
+static const iocshArg *devGenVarStatShowArgs[] = {
+	&devGenVarStatShowArg1,
+	&devGenVarStatShowArg2,
+};
+
+static iocshFuncDef devGenVarStatShowDef = {
+	name: "devGenVarStatShow",
+	nargs: sizeof(devGenVarStatShowArgs)/sizeof(devGenVarStatShowArgs[0]),
+	arg:   devGenVarStatShowArgs,
+};
+
+static void 
+devGenVarStatShowCall(const iocshArgBuf *argBuf)
+{
+	devGenVarStatShow( argBuf[0].ival, argBuf[1].ival );
 }
 
-static struct {
-	long         number;
-	DEVSUPFUN    report;
-	DEVSUPFUN    init;
-	DEVSUPFUN    init_record;
-	DEVSUPFUN    get_ioint_info;
-	DEVSUPFUN    write_record;
-} devMbboGenVar = {
-	5,
-	NULL,
-	NULL,
-	init_rec_mbbo,
-	devGenVarGetIointInfo,
-	write_mbbo
+static const iocshArg devGenVarLockShowArg1 = {
+	name:	"n_top",
+	type:   iocshArgInt,
 };
-epicsExportAddress(dset, devMbboGenVar);
 
-static const iocshArg devGenVarConfigArg1 = {
-	name:	"ld_table_size",
+static const iocshArg devGenVarLockShowArg2 = {
+	name:	"level",
 	type:   iocshArgInt,
 };
 
-static const iocshArg *devGenVarConfigArgs[] = {
-	&devGenVarConfigArg1,
+static const iocshArg *devGenVarLockShowArgs[] = {
+	&devGenVarLockShowArg1,
+	&devGenVarLockShowArg2,
 };
 
-static iocshFuncDef devGenVarConfigDef = {
-	name: "devGenVarConfig",
-	nargs: sizeof(devGenVarConfigArgs)/sizeof(devGenVarConfigArgs[0]),
-	arg:   devGenVarConfigArgs,
+static iocshFuncDef devGenVarLockShowDef = {
+	name: "devGenVarLockShow",
+	nargs: sizeof(devGenVarLockShowArgs)/sizeof(devGenVarLockShowArgs[0]),
+	arg:   devGenVarLockShowArgs,
 };
 
 static void 
-devGenVarConfigCall(const iocshArgBuf *argBuf)
+devGenVarLockShowCall(const iocshArgBuf *argBuf)
 {
-	devGenVarConfig( argBuf->ival );
+	devGenVarLockShow( argBuf[0].ival, argBuf[1].ival );
+}
+
+static const iocshArg devGenVarDeferShowArg1 = {
+	name:	"reset",
+	type:   iocshArgInt,
+};
+
+static const iocshArg *devGenVarDeferShowArgs[] = {
+	&devGenVarDeferShowArg1,
+};
+
+static iocshFuncDef devGenVarDeferShowDef = {
+	name: "devGenVarDeferShow",
+	nargs: sizeof(devGenVarDeferShowArgs)/sizeof(devGenVarDeferShowArgs[0]),
+	arg:   devGenVarDeferShowArgs,
+};
+
+static void 
+devGenVarDeferShowCall(const iocshArgBuf *argBuf)
+{
+	devGenVarDeferShow( argBuf[0].ival );
 }
 
 static void devGenVarRegistrar(void)
 {
-	iocshRegister( &devGenVarConfigDef, devGenVarConfigCall );
+	devGenVarRegInit();
+	initHookRegister( initHook );
+	iocshRegister( &devGenVarConfigDef,        devGenVarConfigCall        );
+	iocshRegister( &devGenVarScanRateDef,      devGenVarScanRateCall      );
+	iocshRegister( &devGenVarScanRateShowDef,  devGenVarScanRateShowCall  );
+	iocshRegister( &devGenVarRegShowDef,       devGenVarRegShowCall       );
+	iocshRegister( &devGenVarArenaShowDef,     devGenVarArenaShowCall     );
+	iocshRegister( &devGenVarStatShowDef,      devGenVarStatShowCall      );
+	iocshRegister( &devGenVarLockShowDef,      devGenVarLockShowCall      );
+	iocshRegister( &devGenVarDeferShowDef,     devGenVarDeferShowCall     );
 }
 
 epicsExportRegistrar(devGenVarRegistrar);
@@ -1,6 +1,7 @@
 #ifndef DEV_GEN_VAR_H
 #define DEV_GEN_VAR_H
 
+#include <dbFldTypes.h>
 #include <dbAddr.h>
 #include <dbScan.h>
 #include <dbCommon.h>
@@ -8,6 +9,16 @@
 #include <epicsEvent.h>
 #include <epicsTime.h>
 #include <string.h>
+#include <stddef.h>
+
+/* The lock-free paths (counters, seqlock, snapshots, FIFO, bit
+ * manipulation) use the __atomic builtins, i.e., GCC 4.7 or later
+ * (or clang). 64-bit atomics on 32-bit targets (e.g., PowerPC)
+ * may be implemented by libatomic; see the Makefile.
+ */
+#if !defined(__ATOMIC_RELAXED)
+#error "devGenVar requires a compiler providing the __atomic builtins (gcc >= 4.7 or clang)"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -55,6 +66,20 @@ extern "C" {
  *
  *       dbr_t:    (mandatory) EPICS DBR type of the generic-varibale/object.               
  *
+ *       n_elms:   (optional) number of elements if data_p points to an
+ *                 array (of 'dbr_t' elements). Zero is treated like one,
+ *                 i.e., a scalar. Array records (waveform, aai, aao)
+ *                 transfer up to n_elms elements; if 'dbr_t' matches
+ *                 the record's FTVL then this is a single memcpy().
+ *
+ *       opts:     (optional) ORed DEV_GEN_VAR_OPT_xxx bits selecting
+ *                 optional modes of operation (see below).
+ *
+ *       deadband: (optional) used by devGenVarUpdate(): a scan is only
+ *                 requested if the new value differs by more than
+ *                 'deadband' from the value that was last scanned.
+ *                 Zero means 'any change'.
+ *
  *  Run-time fields:
  *       ts, stat, 
  *       sevr:     (optional) convey time-stamp, status + severity
@@ -63,8 +88,24 @@ extern "C" {
  *                 write them during phase 1 and read them back during
  *                 phase 2).
  *
+ *       n_supp:   number of scans suppressed by devGenVarUpdate()
+ *                 because the value did not change.
+ *
+ *       stats:    performance counters (see DevGenVarStatsRec below).
+ *
  *  Private fields:
- *       rec_p:    Used internally, initialize to NULL and do not modify.
+ *       asyncq:   Used internally (queue of records in asynchronous
+ *                 processing), initialize to NULL and do not modify.
+ *       seq:      Used internally (seqlock mode), initialize to 0.
+ *       snap,
+ *       snap_off: Used internally (snapshot groups), initialize to 0.
+ *       upd_last,
+ *       upd_valid: Used internally (devGenVarUpdate()), initialize to 0.
+ *       scan_lim: Used internally (devGenVarScanRate()), initialize to 0.
+ *       fifo:     Used internally (devGenVarFifoCreate()), initialize to 0.
+ *       tmpl:     Used internally (devGenVarRegisterStruct()), initialize to 0.
+ *       gen:      Generation counter (DEV_GEN_VAR_OPT_DIRTY), initialize to 0;
+ *                 use devGenVarMarkDirty() to increment.
  *
  *  NOTE: Only the mandatory and optional fields that you intend to use 
  *        need to be filled by you. Unused optional fields may remain
@@ -78,17 +119,109 @@ extern "C" {
 typedef epicsEventId DevGenVarEvt; 
 typedef epicsMutexId DevGenVarMtx;
 
+/* Performance counters. These are updated with relaxed atomic
+ * increments. Define DEV_GEN_VAR_NO_STATS when compiling
+ * devGenVar (and your code) in order to compile them out
+ * (the fields remain but stay zero).
+ */
+typedef struct DevGenVarStatsRec_ {
+	unsigned long   n_rd;          /* transfers GenVar -> input record   */
+	unsigned long   n_wr;          /* transfers output record -> GenVar  */
+	unsigned long   n_cvt_err;     /* failed conversions                 */
+	unsigned long   n_evt;         /* events posted                      */
+	unsigned long   n_conflict;    /* async. conflicts (S_dev_Conflict)  */
+	unsigned long   n_scan;        /* scans requested                    */
+	unsigned long   n_clean;       /* reads skipped (DEV_GEN_VAR_OPT_DIRTY) */
+} DevGenVarStatsRec;
+
+#ifdef DEV_GEN_VAR_NO_STATS
+#define DEV_GEN_VAR_STAT_INC(p, cnt) do {} while (0)
+#else
+#define DEV_GEN_VAR_STAT_INC(p, cnt) __atomic_fetch_add( &(p)->stats.cnt, 1, __ATOMIC_RELAXED )
+#endif
+
 typedef struct DevGenVarRec_ {
 	IOSCANPVT      *scan_p;        /* scanlist (may be NULL)            */
 	DevGenVarMtx    mtx;           /* protection (may be NULL)          */
 	DevGenVarEvt    evt;           /* synchronization (may be NULL)     */
 	volatile void  *data_p;        /* data we want to transfer          */
 	unsigned        dbr_t;         /* DBR type of data we want to transfer from/to field */
+	unsigned        n_elms;        /* number of elements (0 or 1: scalar)                */
 	epicsTimeStamp  ts;            /* timestamp (if TSE == epicsTimeEventDeviceTime)     */
 	epicsEnum16     stat, sevr;    /* status + severity                                  */
-	dbCommon       *rec_p;         /* INTERNAL USE ONLY; DO NOT TOUCH                    */
+	struct DevGenVarAsyncQRec_ *asyncq; /* INTERNAL USE ONLY; DO NOT TOUCH               */
+	unsigned        opts;          /* DEV_GEN_VAR_OPT_xxx                                */
+	epicsUInt32     seq;           /* INTERNAL USE ONLY; DO NOT TOUCH                    */
+	struct DevGenVarSnapRec_ *snap;/* INTERNAL USE ONLY; DO NOT TOUCH                    */
+	size_t          snap_off;      /* INTERNAL USE ONLY; DO NOT TOUCH                    */
+	double          deadband;      /* devGenVarUpdate() scans only if change > deadband  */
+	double          upd_last;      /* INTERNAL USE ONLY; DO NOT TOUCH                    */
+	int             upd_valid;     /* INTERNAL USE ONLY; DO NOT TOUCH                    */
+	unsigned long   n_supp;        /* # of scans suppressed by devGenVarUpdate()         */
+	struct DevGenVarScanLimRec_ *scan_lim; /* INTERNAL USE ONLY; DO NOT TOUCH            */
+	struct DevGenVarFifoRec_    *fifo;     /* INTERNAL USE ONLY; DO NOT TOUCH            */
+	struct DevGenVarRec_        *tmpl;     /* INTERNAL USE ONLY; DO NOT TOUCH            */
+	epicsUInt32     gen;           /* generation; see devGenVarMarkDirty()               */
+	DevGenVarStatsRec stats;       /* performance counters                               */
 } DevGenVarRec, *DevGenVar;
 
+/* Option bits for the 'opts' member.
+ *
+ * DEV_GEN_VAR_OPT_SEQLOCK:
+ *       The GenVar has a single writer (your low-level code) which
+ *       brackets every update of *data_p, ts, stat and sevr with
+ *       devGenVarSeqBegin() / devGenVarSeqEnd(). These never block.
+ *       Input records read without taking 'mtx'; they retry until they
+ *       obtain a consistent copy. Output records cannot be attached
+ *       to such a GenVar (there would be a second writer).
+ */
+#define DEV_GEN_VAR_OPT_SEQLOCK    (1<<0)
+
+/*
+ * DEV_GEN_VAR_OPT_ATOMIC:
+ *       For GenVars of integer type (DBR_CHAR .. DBR_ULONG, DBR_ENUM,
+ *       DBR_INT64/DBR_UINT64) shared by bo/mbbo records and low-level
+ *       code manipulating individual bits. The bo/mbbo records merge
+ *       their (masked) RVAL into *data_p with a compare-and-swap loop
+ *       and do not take 'mtx'. Low-level code must modify the variable
+ *       only with devGenVarSetBits() / devGenVarClearBits() (or other
+ *       atomic operations). Asynchronous records and GenVars with a
+ *       FIFO fall back to the mutex. The lock-free write does not
+ *       copy the record's status/severity into the GenVar's 'stat'
+ *       and 'sevr' (which are protected by 'mtx'). Every merge
+ *       counts as a change (devGenVarMarkDirty()).
+ */
+#define DEV_GEN_VAR_OPT_ATOMIC     (1<<1)
+
+/*
+ * DEV_GEN_VAR_OPT_DEFER:
+ *       devGenVarProcComplete() does not process the asynchronous
+ *       record in the caller's thread but queues phase 2 to an
+ *       EPICS callback thread (priority 'devGenVarDeferPrio', see
+ *       devGenVarProcComplete()) and returns immediately.
+ */
+#define DEV_GEN_VAR_OPT_DEFER      (1<<2)
+
+/*
+ * DEV_GEN_VAR_OPT_DIRTY:
+ *       Input records scanned 'I/O Intr' only read the GenVar if
+ *       it changed since they last read it, i.e., if the producer
+ *       called devGenVarMarkDirty() in the meantime. devGenVarUpdate()
+ *       and devGenVarUpdateBatch() (if the value changed), output
+ *       records, devGenVarSetBits()/ClearBits(), the 64-bit Store/Add
+ *       routines and devGenVarSeqEnd() do this for you; code writing
+ *       the variable directly under the lock must call it. Records attached to a clean GenVar skip the
+ *       conversion (and thus post no value monitors) when the
+ *       scan-list they share with other GenVars is requested.
+ *       Periodic and passive scans and asynchronous records always
+ *       read. Not supported for snapshot groups.
+ *       NOTE: array records (waveform, aai) keep their buffer and NORD
+ *       but their record support still posts VAL on every scan; use
+ *       MPST/APST "On Change" (where the record has them) to avoid
+ *       that.
+ */
+#define DEV_GEN_VAR_OPT_DIRTY      (1<<3)
+
 /*
  * Initialize an array of DevGenVarRec's. Must be called
  * before you set individual fields.
@@ -130,8 +263,20 @@ devGenVarInitScanPvt( DevGenVar p, int n_entries );
  * In this example both variables are connected to the same scan-list.
  */
 #define DEV_GEN_VAR_INIT( scan, mutx, evnt, data, type ) \
+	DEV_GEN_VAR_INIT_ARR( scan, mutx, evnt, data, type, 1 )
+
+/*
+ * Same as DEV_GEN_VAR_INIT() but for an array of 'nelms' elements:
+ *
+ *    epicsInt16   myBuf[1000];
+ *
+ *    DevGenVarRec myArr[] = {
+ *      DEV_GEN_VAR_INIT_ARR( &my_scanlist, 0, 0, myBuf, DBR_SHORT, 1000 ),
+ *    };
+ */
+#define DEV_GEN_VAR_INIT_ARR( scan, mutx, evnt, data, type, nelms ) \
 	{ scan_p: (scan), mtx: (mutx), evt: (evnt), data_p: (data), dbr_t: (type), \
-      ts: { 0, 0 }, stat: 0, sevr: 0, rec_p: 0 }
+      n_elms: (nelms), ts: { 0, 0 }, stat: 0, sevr: 0, asyncq: 0 }
 
 /*
  * Register an array of DevGenVarRec's so that the device-support module
@@ -147,6 +292,68 @@ devGenVarInitScanPvt( DevGenVar p, int n_entries );
 long
 devGenVarRegister(const char *registryEntry, DevGenVar p, int n_entries);
 
+/*
+ * Struct-layout binding: register the members of a C struct under a
+ * single name instead of one DevGenVarRec per member.
+ *
+ *   typedef struct MyState_ {
+ *     epicsUInt32 rxBytes;
+ *     epicsUInt32 txBytes;
+ *     epicsInt16  temp[4];
+ *   } MyState;
+ *
+ *   MyState myState;
+ *
+ *   static const DevGenVarMemberRec myStateMembers[] = {
+ *     DEV_GEN_VAR_MEMBER(     MyState, rxBytes, DBR_ULONG ),
+ *     DEV_GEN_VAR_MEMBER(     MyState, txBytes, DBR_ULONG ),
+ *     DEV_GEN_VAR_MEMBER_ARR( MyState, temp,    DBR_SHORT ),
+ *   };
+ *
+ *   DevGenVarRec myStateGv = DEV_GEN_VAR_INIT( &myScanList, myMtx, 0, &myState, 0 );
+ *
+ *   devGenVarRegisterStruct( "myState", &myStateGv, myStateMembers,
+ *                            sizeof(myStateMembers)/sizeof(myStateMembers[0]) );
+ *
+ * Records select a member with the link parameter, e.g.,
+ *
+ *   field(INP, "#C0 S0 @myState.rxBytes")
+ *
+ * 'p' is a template: its 'data_p' points to the struct and its
+ * scan_p, mtx, evt, opts and deadband are shared by all members,
+ * i.e., all members use one lock and one scan-list. Use 'p' for
+ * locking and scanning from low-level code (devGenVarLock( p ),
+ * devGenVarScan( p ), ...). A DevGenVarRec is created (and
+ * registered as "<registryEntry>.<member>") only for members which
+ * are actually referenced by a record.
+ * Member records use the template's 'ts', 'stat' and 'sevr' (output
+ * members set them), so low-level code sets these on 'p' only.
+ * The template must not be in SEQLOCK mode, attached to a snapshot
+ * group or have a FIFO (the members would not share its sequence
+ * counter, copies or queue), and member records cannot use
+ * asynchronous processing.
+ *
+ * RETURNS: zero on success, nonzero on failure.
+ *
+ * NOTE   : 'p' and 'members' are 'taken over' (see devGenVarRegister()).
+ */
+typedef struct DevGenVarMemberRec_ {
+	const char     *name;
+	size_t          offset;
+	unsigned        dbr_t;
+	unsigned        n_elms;
+} DevGenVarMemberRec, *DevGenVarMember;
+
+#define DEV_GEN_VAR_MEMBER( styp, memb, type ) \
+	{ name: #memb, offset: offsetof(styp, memb), dbr_t: (type), n_elms: 1 }
+
+#define DEV_GEN_VAR_MEMBER_ARR( styp, memb, type ) \
+	{ name: #memb, offset: offsetof(styp, memb), dbr_t: (type), \
+	  n_elms: sizeof(((styp*)0)->memb)/sizeof(((styp*)0)->memb[0]) }
+
+long
+devGenVarRegisterStruct(const char *registryEntry, DevGenVar p, const DevGenVarMemberRec *members, int n_members);
+
 /*
  * Create an event and attach to 'p'. Always use this routine - the
  * underlying object may change in the future!
@@ -207,16 +414,45 @@ devGenVarLockCreateRaw(void)
 	return epicsMutexMustCreate();
 }
 
+/*
+ * Instrumented locking: while 'devGenVarLockProf' is nonzero
+ * (iocsh: 'var devGenVarLockProf 1') the lock routines below
+ * record wait- and hold-times of every mutex in log2 histograms.
+ * 'devGenVarLockShow()' (also an iocsh command) prints the
+ * 'n_top' mutexes with the highest accumulated wait time
+ * (histograms if 'level' > 0).
+ * Mutexes acquired while profiling was on are released through the
+ * profiling path even if it has been switched off in the meantime
+ * ('devGenVarLockProfHeld' counts them).
+ */
+extern int      devGenVarLockProf;
+extern unsigned devGenVarLockProfHeld;
+
+void
+devGenVarLockProfLock(DevGenVarMtx mtx);
+
+void
+devGenVarLockProfUnlock(DevGenVarMtx mtx);
+
+void
+devGenVarLockShow(int n_top, int level);
+
 static __inline__ void
 devGenVarLockRaw(DevGenVarMtx mtx)
 {
-	epicsMutexMustLock( mtx );
+	if ( devGenVarLockProf )
+		devGenVarLockProfLock( mtx );
+	else
+		epicsMutexMustLock( mtx );
 }
 
 static __inline__ void
 devGenVarUnlockRaw(DevGenVarMtx mtx)
 {
-	epicsMutexUnlock( mtx );
+	if ( devGenVarLockProf || __atomic_load_n( &devGenVarLockProfHeld, __ATOMIC_RELAXED ) )
+		devGenVarLockProfUnlock( mtx );
+	else
+		epicsMutexUnlock( mtx );
 }
 
 
@@ -227,37 +463,472 @@ static __inline__ void
 devGenVarLock(DevGenVar p)
 {
 	if ( p->mtx )
-		epicsMutexMustLock( p->mtx );
+		devGenVarLockRaw( p->mtx );
 }
 
 static __inline__ void
 devGenVarUnlock(DevGenVar p)
 {
 	if ( p->mtx )
-		epicsMutexUnlock( p->mtx );
+		devGenVarUnlockRaw( p->mtx );
 }
 
+/*
+ * Store a new value and request a scan only if it changed.
+ *
+ * 'val_p' points to the new value which must be of the GenVar's
+ * 'dbr_t' type (an array of 'n_elms' elements for array GenVars).
+ * The value is copied into *data_p (holding the GenVar's lock or
+ * seqlock) and 'ts' (if non-NULL) into the GenVar's timestamp.
+ * The GenVar's scan-list is then requested only if the value
+ * changed or - if 'deadband' is nonzero - moved by more than
+ * 'deadband' away from the value that was last scanned. Otherwise
+ * the GenVar's 'n_supp' counter is incremented. The first update
+ * always scans (with or without a deadband, even if the value
+ * equals the initial contents); with a deadband a change from or
+ * to NaN counts as a change.
+ *
+ * RETURNS: 1 if a scan was requested, 0 if the scan was suppressed
+ *          and a negative value on error (unsupported type, GenVar
+ *          is member of a snapshot group).
+ */
+long
+devGenVarUpdate(DevGenVar p, const void *val_p, const epicsTimeStamp *ts);
+
+/*
+ * Batch update: store many values and request every scan-list once.
+ *
+ * Each element of the 'upd' array names a GenVar and a pointer to
+ * its new value (of the GenVar's 'dbr_t' type; 'n_elms' elements).
+ * All values are written (with timestamp 'ts' unless NULL), taking
+ * each distinct mutex only once (GenVars in SEQLOCK mode use their
+ * seqlock instead). Afterwards, each distinct scan-list is requested
+ * exactly once (subject to devGenVarScanRate()).
+ *
+ * NOTE: The 'upd' array is not modified; the routine sorts a private
+ *       array of pointers (on the stack for up to 64 elements).
+ *       The mutexes are taken one at a time, i.e., updates of GenVars
+ *       with different mutexes are not atomic with respect to each
+ *       other.
+ *
+ * RETURNS: number of scan-lists requested or a negative value if
+ *          any of the elements could not be written (unsupported type
+ *          or member of a snapshot group); the others are written
+ *          anyways. Also negative if 'n' is not positive (nothing
+ *          is done).
+ */
+typedef struct DevGenVarUpdRec_ {
+	DevGenVar   gv;
+	const void *val_p;
+} DevGenVarUpdRec, *DevGenVarUpd;
+
+long
+devGenVarUpdateBatch(DevGenVarUpd upd, int n, const epicsTimeStamp *ts);
+
+/* Typed variants of devGenVarUpdate(); these fail (returning -1)
+ * if the GenVar's 'dbr_t' does not match.
+ */
+static __inline__ long
+devGenVarUpdateShort(DevGenVar p, epicsInt16 val, const epicsTimeStamp *ts)
+{
+	return DBR_SHORT == p->dbr_t ? devGenVarUpdate( p, &val, ts ) : -1;
+}
+
+static __inline__ long
+devGenVarUpdateUShort(DevGenVar p, epicsUInt16 val, const epicsTimeStamp *ts)
+{
+	return DBR_USHORT == p->dbr_t ? devGenVarUpdate( p, &val, ts ) : -1;
+}
+
+static __inline__ long
+devGenVarUpdateLong(DevGenVar p, epicsInt32 val, const epicsTimeStamp *ts)
+{
+	return DBR_LONG == p->dbr_t ? devGenVarUpdate( p, &val, ts ) : -1;
+}
+
+static __inline__ long
+devGenVarUpdateULong(DevGenVar p, epicsUInt32 val, const epicsTimeStamp *ts)
+{
+	return DBR_ULONG == p->dbr_t ? devGenVarUpdate( p, &val, ts ) : -1;
+}
+
+static __inline__ long
+devGenVarUpdateFloat(DevGenVar p, epicsFloat32 val, const epicsTimeStamp *ts)
+{
+	return DBR_FLOAT == p->dbr_t ? devGenVarUpdate( p, &val, ts ) : -1;
+}
+
+static __inline__ long
+devGenVarUpdateDouble(DevGenVar p, epicsFloat64 val, const epicsTimeStamp *ts)
+{
+	return DBR_DOUBLE == p->dbr_t ? devGenVarUpdate( p, &val, ts ) : -1;
+}
+
+/*
+ * Mark a GenVar as modified (DEV_GEN_VAR_OPT_DIRTY); call after
+ * storing a new value and before devGenVarScan(). The writers
+ * in this header and devGenVarUpdate() etc. do this for you.
+ */
+static __inline__ void
+devGenVarMarkDirty(DevGenVar p)
+{
+	__atomic_fetch_add( &p->gen, 1, __ATOMIC_RELEASE );
+}
+
+#ifdef DBR_INT64
+static __inline__ long
+devGenVarUpdateInt64(DevGenVar p, epicsInt64 val, const epicsTimeStamp *ts)
+{
+	return DBR_INT64 == p->dbr_t ? devGenVarUpdate( p, &val, ts ) : -1;
+}
+
+static __inline__ long
+devGenVarUpdateUInt64(DevGenVar p, epicsUInt64 val, const epicsTimeStamp *ts)
+{
+	return DBR_UINT64 == p->dbr_t ? devGenVarUpdate( p, &val, ts ) : -1;
+}
+
+/*
+ * 64-bit variables (EPICS 3.16 and later).
+ *
+ * Records read a naturally aligned DBR_INT64/DBR_UINT64 GenVar into an
+ * int64in/int64out VAL with a single atomic load (a plain load on
+ * 64-bit hosts). A counter that is only written with the routines
+ * below therefore needs no mutex (leave 'mtx' NULL):
+ *
+ *   devGenVarAddUInt64( &myByteCount, nbytes );
+ *   devGenVarScan( &myByteCount );
+ */
+static __inline__ void
+devGenVarStoreInt64(DevGenVar p, epicsInt64 val)
+{
+	__atomic_store_n( (epicsInt64*)p->data_p, val, __ATOMIC_RELAXED );
+	devGenVarMarkDirty( p );
+}
+
+static __inline__ void
+devGenVarStoreUInt64(DevGenVar p, epicsUInt64 val)
+{
+	__atomic_store_n( (epicsUInt64*)p->data_p, val, __ATOMIC_RELAXED );
+	devGenVarMarkDirty( p );
+}
+
+static __inline__ void
+devGenVarAddUInt64(DevGenVar p, epicsUInt64 inc)
+{
+	__atomic_fetch_add( (epicsUInt64*)p->data_p, inc, __ATOMIC_RELAXED );
+	devGenVarMarkDirty( p );
+}
+#endif
+
+/*
+ * Atomically set or clear bits in an integer GenVar (see
+ * DEV_GEN_VAR_OPT_ATOMIC); these never block. Bits beyond the
+ * width of 'dbr_t' are ignored. The previous value is stored in
+ * *old_p unless 'old_p' is NULL.
+ *
+ *   devGenVarSetBits( &myStatusWord, 0x10, 0 );
+ *   devGenVarScan( &myStatusWord );
+ *
+ * RETURNS: zero on success, nonzero if 'dbr_t' is not an integer type.
+ */
+long
+devGenVarSetBits(DevGenVar p, epicsUInt32 bits, epicsUInt32 *old_p);
+
+long
+devGenVarClearBits(DevGenVar p, epicsUInt32 bits, epicsUInt32 *old_p);
+
+/* Writer side of a GenVar in DEV_GEN_VAR_OPT_SEQLOCK mode.
+ * These never block. Only a single thread may write a given
+ * GenVar. Example:
+ *
+ *   devGenVarSeqBegin( &myGenVar );
+ *     myValue        = new_value;
+ *     myGenVar.ts    = now;
+ *   devGenVarSeqEnd( &myGenVar );
+ *   devGenVarScan( &myGenVar );
+ *
+ * devGenVarSeqEnd() marks the GenVar dirty (DEV_GEN_VAR_OPT_DIRTY);
+ * devGenVarSeqEndNoMark() does not, for writers which only mark
+ * it if the value actually changed.
+ */
+static __inline__ void
+devGenVarSeqBegin(DevGenVar p)
+{
+	/* odd sequence number: update in progress */
+	__atomic_store_n( &p->seq, p->seq + 1, __ATOMIC_RELAXED );
+	__atomic_thread_fence( __ATOMIC_RELEASE );
+}
+
+static __inline__ void
+devGenVarSeqEndNoMark(DevGenVar p)
+{
+	__atomic_store_n( &p->seq, p->seq + 1, __ATOMIC_RELEASE );
+}
+
+static __inline__ void
+devGenVarSeqEnd(DevGenVar p)
+{
+	devGenVarSeqEndNoMark( p );
+	devGenVarMarkDirty( p );
+}
+
+/*
+ * Rate-limited scanning. The scan-lists of all GenVars registered
+ * under 'name' are requested at most 'max_rate' times per second
+ * by devGenVarScan() (and devGenVarUpdate()). Requests arriving
+ * within 1/max_rate seconds of the last scan are coalesced into a
+ * single scan which is issued at the end of that window (from a
+ * timer thread).
+ * A 'max_rate' <= 0 removes the limit again.
+ *
+ * GenVars sharing a scan-list share the same limiter. Note that
+ * GenVars registered under a different name bypass the limiter
+ * unless they are configured, too.
+ *
+ * Call this after devGenVarRegister() but before your code starts
+ * scanning.
+ *
+ * RETURNS: zero on success, nonzero on error (no such entry,
+ *          no memory).
+ */
+int
+devGenVarScanRate(const char *name, double max_rate);
+
+/* Print rate-limiter statistics (requests, scans, coalesced requests) */
+void
+devGenVarScanRateShow(void);
+
+/*
+ * Print the 'n' GenVars with the highest total of reads, writes
+ * and scans (iocsh: devGenVarStatShow). If 'reset' is nonzero
+ * then all counters are cleared after printing.
+ */
+void
+devGenVarStatShow(int n, int reset);
+
+/* Used by devGenVarScan(); do not call directly */
+void
+devGenVarScanLimited(struct DevGenVarScanLimRec_ *l);
+
 static __inline__ void
 devGenVarScan(DevGenVar p)
 {
-	if ( p->scan_p )
+	DEV_GEN_VAR_STAT_INC( p, n_scan );
+	if ( p->scan_lim )
+		devGenVarScanLimited( p->scan_lim );
+	else if ( p->scan_p )
 		scanIoRequest( *p->scan_p );
 }
 
-/* EPICS' 'general-purpose' hash table
- * is of limited size :-(
- * Call this *before* iocInit and *before*
- * the first call to devGenVarRegister() in
- * order to configure the table used by
- * devGenVar.
- * 
- * The 'ldTableSize' argument has to be
- * bigger or equal to 8 and less than or
- * equal to 16.
+/*
+ * Snapshot groups: consistent, lock-free reads of many GenVars.
+ *
+ * A snapshot group holds two copies ('front' and 'back') of a block of
+ * memory, usually a struct containing all of the variables. GenVars
+ * are attached to the group at an offset into that block. Records read
+ * the front copy without taking any lock while your code fills the back
+ * copy and then publishes it with a single pointer flip.
+ * All records reading the front copy thus see values from the same
+ * producer cycle.
+ *
+ *   typedef struct { epicsInt32 cnt; double volt; } MyData;
+ *
+ *   IOSCANPVT     myList;
+ *   DevGenVarRec  myVars[2];
+ *   DevGenVarSnap mySnap;
+ *   MyData       *d;
+ *
+ *   scanIoInit( &myList );
+ *   devGenVarInit( myVars, 2 );
+ *   mySnap = devGenVarSnapCreate( sizeof(MyData), &myList );
+ *   myVars[0].dbr_t = DBR_LONG;
+ *   devGenVarSnapAttach( &myVars[0], mySnap, offsetof(MyData, cnt)  );
+ *   myVars[1].dbr_t = DBR_DOUBLE;
+ *   devGenVarSnapAttach( &myVars[1], mySnap, offsetof(MyData, volt) );
+ *   devGenVarRegister( "myVars", myVars, 2 );
+ *
+ *   // producer; never blocks
+ *   if ( (d = devGenVarSnapBack( mySnap )) ) {
+ *      d->cnt++;
+ *      d->volt = readVoltage();
+ *      devGenVarSnapPublish( mySnap, &now, 0, 0 );
+ *   }
+ *
+ * Only a single thread may produce into a given group. Output records
+ * cannot be attached to GenVars which are members of a snapshot group.
+ * The group should be published no faster than the scan-list can be
+ * processed - otherwise records processed by the same scan may see
+ * different (but each self-consistent) copies.
+ */
+typedef struct DevGenVarSnapRec_ *DevGenVarSnap;
+
+/*
+ * Create a snapshot group of 'size' bytes (both copies are zeroed).
+ * 'scan_p' (may be NULL) is the scan-list which is requested by
+ * devGenVarSnapPublish().
+ *
+ * RETURNS: group handle or NULL (no memory).
+ */
+DevGenVarSnap
+devGenVarSnapCreate(size_t size, IOSCANPVT *scan_p);
+
+/*
+ * Attach a GenVar to a snapshot group. The GenVar's data are located
+ * 'offset' bytes into the group's memory block; 'dbr_t' and 'n_elms'
+ * must already be set. The GenVar's 'scan_p' is set to the group's
+ * scan-list unless it was set already.
+ * Call this before registering the GenVar. DEV_GEN_VAR_OPT_DIRTY
+ * cannot be used (a published copy is not marked per variable).
+ *
+ * RETURNS: zero on success, nonzero if the variable does not fit
+ *          or uses DEV_GEN_VAR_OPT_DIRTY.
+ */
+long
+devGenVarSnapAttach(DevGenVar p, DevGenVarSnap s, size_t offset);
+
+/*
+ * Obtain the back copy for writing. The first call after a
+ * devGenVarSnapPublish() refreshes the back copy with the current
+ * front contents so that you may update just some of the variables.
+ *
+ * RETURNS: pointer to the back copy or NULL if readers are still
+ *          using it (i.e., the previous copy has not been fully
+ *          consumed yet). Never blocks.
+ */
+void *
+devGenVarSnapBack(DevGenVarSnap s);
+
+/*
+ * Publish the back copy (which must have been obtained with
+ * devGenVarSnapBack()) with timestamp (current time if 'ts' is NULL),
+ * status and severity. The copies are flipped and the group's
+ * scan-list is requested (with devGenVarScan() on an attached
+ * variable, i.e., subject to devGenVarScanRate()).
+ *
+ * RETURNS: zero on success, nonzero if devGenVarSnapBack() was not
+ *          called (successfully) since the last publish.
+ */
+long
+devGenVarSnapPublish(DevGenVarSnap s, const epicsTimeStamp *ts, epicsEnum16 stat, epicsEnum16 sevr);
+
+/*
+ * Output FIFO: lossless write queue.
+ *
+ * Normally, an output record writes *data_p and a second write
+ * overwrites the first one if low-level code did not consume it
+ * in the meantime. After devGenVarFifoCreate() every write by an
+ * output record appends (value, timestamp, stat, sevr) to a
+ * bounded, lock-free ring of 'depth' entries (rounded up to a power
+ * of two) instead; *data_p is not written. Low-level code retrieves
+ * the entries with devGenVarDequeue(), usually draining the FIFO
+ * whenever devGenVarWait() returns:
+ *
+ *   epicsInt32 val;
+ *
+ *   devGenVarFifoCreate( &myGenVar, 64, DEV_GEN_VAR_FIFO_OUT );
+ *   devGenVarRegister( "myCmds", &myGenVar, 1 );
+ *
+ *   while ( 1 ) {
+ *     devGenVarWait( &myGenVar, -1. );
+ *     while ( devGenVarDequeue( &myGenVar, &val, 0, 0, 0 ) > 0 ) {
+ *       execute( val );
+ *     }
+ *   }
+ *
+ * A write finding the FIFO full is dropped, counted (see
+ * devGenVarFifoOverflows()) and the record raises a WRITE/INVALID
+ * alarm; an asynchronous record then does not enter phase 1.
+ * Since *data_p is not written, bo/mbbo records with a MASK (or
+ * NOBT, i.e., writing only some bits) cannot be attached to a
+ * GenVar with a FIFO (init_record fails).
+ *
+ * Call devGenVarFifoCreate() before iocInit, after setting
+ * 'dbr_t' and 'n_elms'. 'dir' is the direction of the FIFO:
+ * DEV_GEN_VAR_FIFO_OUT (written by output records, read with
+ * devGenVarDequeue()) or DEV_GEN_VAR_FIFO_IN (written with
+ * devGenVarPush(), read by input records; see below). Records
+ * of the other direction cannot be attached to the GenVar
+ * (init_record fails); input and output records thus never
+ * consume each other's entries.
+ *
+ * RETURNS: zero on success, nonzero on error (no memory, FIFO
+ *          exists already, bad type or direction).
+ */
+#define DEV_GEN_VAR_FIFO_OUT 0
+#define DEV_GEN_VAR_FIFO_IN  1
+
+long
+devGenVarFifoCreate(DevGenVar p, unsigned depth, int dir);
+
+/*
+ * Remove the oldest entry from the FIFO. The value (GV_NELMS
+ * elements of type 'dbr_t') is copied to 'buf'; timestamp, status
+ * and severity are stored unless the respective pointer is NULL.
+ * May be called from any number of threads; never blocks.
+ *
+ * RETURNS: number of elements written to 'buf' (> 0) if an entry
+ *          was removed, zero if the FIFO was empty, negative if 'p'
+ *          has no output FIFO.
+ */
+long
+devGenVarDequeue(DevGenVar p, void *buf, epicsTimeStamp *ts, epicsEnum16 *stat, epicsEnum16 *sevr);
+
+/*
+ * Input FIFO (DEV_GEN_VAR_FIFO_IN): the same FIFO also works in
+ * the other direction.
+ * The producer appends samples with devGenVarPush() which never
+ * blocks and requests the GenVar's scan-list. Each time an input
+ * record attached to the GenVar is processed it consumes exactly
+ * one sample (value, timestamp, status, severity) and, if more
+ * samples are pending, requests the scan-list again. Thus every
+ * sample of a burst is processed (and archived) individually;
+ * use TSE = -2 for the record to carry the sample's timestamp.
+ * A record processed while the FIFO is empty (e.g., by a periodic
+ * scan or a forward link) keeps its value but still completes
+ * processing: it gets a new timestamp (unless TSE = -2), its alarm
+ * is reset, forward links are processed and monitors are posted
+ * as the record support sees fit.
+ *
+ * Attach a single input record (SCAN = 'I/O Intr') to a GenVar
+ * with an input FIFO; several records would share the samples.
+ *
+ *   epicsInt32     sample;
+ *   epicsTimeStamp ts;
+ *
+ *   devGenVarFifoCreate( &myGenVar, 1024, DEV_GEN_VAR_FIFO_IN );
+ *   devGenVarInitScanPvt( &myGenVar, 1 );
+ *   ...
+ *   while ( acquire( &sample, &ts ) ) {
+ *     if ( devGenVarPush( &myGenVar, &sample, 1, &ts, NO_ALARM, NO_ALARM ) )
+ *       lost++;
+ *   }
+ *
+ * 'n' is the number of elements in 'val_p' (values <= 0 or larger
+ * than n_elms mean n_elms); a NULL 'ts' stores the current time.
+ *
+ * RETURNS: zero on success, nonzero if the FIFO is full (the sample
+ *          is dropped and counted as an overflow) or 'p' has no
+ *          input FIFO.
+ */
+long
+devGenVarPush(DevGenVar p, const void *val_p, long n, const epicsTimeStamp *ts, epicsEnum16 stat, epicsEnum16 sevr);
+
+/*
+ * RETURNS: number of writes dropped because the FIFO was full.
+ */
+unsigned long
+devGenVarFifoOverflows(DevGenVar p);
+
+/* OBSOLETE: devGenVar used to keep its registry in
+ * a fixed-size EPICS 'general-purpose' hash table
+ * which had to be sized by this routine.
+ * The registry now grows by itself (use the iocsh
+ * command 'devGenVarRegShow' to inspect it).
+ * This routine is retained for compatibility and
+ * does nothing.
  *
- * RETURNS: Zero on success, nonzero
- * on failure (returning the current
- * table size).
+ * RETURNS: Zero.
  */
 int
 devGenVarConfig(unsigned ldTableSize);
@@ -273,15 +944,107 @@ devGenVarConfig(unsigned ldTableSize);
  *  4) set pact and complete first processing step
  *  5) ll-code uses value
  *  6) ll-code sets timestamp, stat + severity
- *  7) ll-code calls devGenVarProcComplete();
+ *  7) ll-code calls devGenVarProcComplete() which records
+ *     the timestamp, stat + severity with the completed record;
  *  8) record processes second time, sets timestamp
  *     (if TSE == epicsTimeEventDeviceTime), stat + sevr
  *  9) done.
+ *
+ * Asynchronous records need a GenVar with a mutex (which protects
+ * the queue of pending records) that is neither in SEQLOCK mode
+ * nor a member of a snapshot group.
+ *
+ * NOTE: devGenVarProcComplete() must be called WITHOUT holding the
+ *       GenVar's lock. It locks the record (dbScanLock()) while
+ *       record processing takes the lock set first and the GenVar's
+ *       lock second; holding the latter would risk a deadlock.
+ *
+ * Asynchronous input records work alike: phase 1 posts the
+ * event (nothing is read); ll-code stores the value, timestamp,
+ * stat + severity and calls devGenVarProcComplete(); phase 2
+ * reads them into the record.
+ *
+ * Several asynchronous records may be attached to a single
+ * GenVar; records which are in phase 1 are queued (in the
+ * order in which they processed). devGenVarProcComplete()
+ * completes the oldest one. *data_p holds the value written
+ * last; the value each pending output record wrote is kept
+ * with its queue entry (see devGenVarProcPendingGet()). Only
+ * the oldest pending record writes its status/severity to the
+ * GenVar so that they are not modified while ll-code works
+ * on that record.
+ *
+ * If the GenVar has the DEV_GEN_VAR_OPT_DEFER option then
+ * phase 2 is run by an EPICS callback thread and
+ * devGenVarProcComplete() returns without waiting for the
+ * record (or its lock set). The callback priority is selected
+ * by the variable 'devGenVarDeferPrio' (0: low, 1: medium
+ * (default), 2: high; iocsh: var devGenVarDeferPrio 2). Use
+ * callbackParallelThreads() to have a pool of threads serve a
+ * priority. The timestamp, status and severity are those
+ * set when devGenVarProcComplete() was called but phase 2 of
+ * an input record reads the value when it runs, i.e., ll-code
+ * should not modify it until the record has completed.
+ * 'devGenVarDeferShow' reports the depth of the queue and the
+ * delay of phase 2. If the callback queue is full then phase 2
+ * runs in the caller's thread.
+ *
+ * RETURNS: zero on success, nonzero if no record was pending.
  */
 
 int
 devGenVarProcComplete(DevGenVar p);
 
+/*
+ * Complete asynchronous processing of a particular record
+ * (which is removed from the queue of pending records).
+ *
+ * RETURNS: zero on success, nonzero if 'prec' was not pending.
+ */
+int
+devGenVarProcCompleteRec(DevGenVar p, dbCommon *prec);
+
+/*
+ * RETURNS: number of records waiting for devGenVarProcComplete().
+ *          The oldest one is stored in *oldest_p (unless NULL).
+ *          Call this with the GenVar locked if you need the answer
+ *          to remain valid.
+ */
+int
+devGenVarProcPending(DevGenVar p, dbCommon **oldest_p);
+
+/*
+ * Obtain the value the oldest pending output record wrote in
+ * phase 1 (even if other records wrote to the GenVar since).
+ * The value is copied to 'buf' (if non-NULL; room for 'n_elms'
+ * elements of type 'dbr_t'); the record's status and severity
+ * at the time of writing are stored in *stat_p and *sevr_p and
+ * the record in *prec_p (unless NULL), e.g., for passing it to
+ * devGenVarProcCompleteRec() if several threads complete
+ * records of the same GenVar:
+ *
+ *   while ( devGenVarProcPendingGet( &myGenVar, &val, 0, 0, 0 ) > 0 ) {
+ *     consume( val );
+ *     devGenVarProcComplete( &myGenVar );
+ *   }
+ *
+ * RETURNS: number of elements copied, zero if the oldest pending
+ *          record is an input record (*prec_p is still set) or
+ *          a negative value if no record is pending.
+ */
+int
+devGenVarProcPendingGet(DevGenVar p, void *buf, epicsEnum16 *stat_p, epicsEnum16 *sevr_p, dbCommon **prec_p);
+
+/*
+ * Print statistics of deferred completion (DEV_GEN_VAR_OPT_DEFER):
+ * requests, current and maximal queue depth and the average and
+ * maximal delay between devGenVarProcComplete() and the start of
+ * phase 2 (iocsh: devGenVarDeferShow). If 'reset' is nonzero then
+ * the statistics are cleared after printing.
+ */
+long
+devGenVarDeferShow(int reset);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,136 @@
+#include <epicsMutex.h>
+#include <epicsThread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "devGenVarArena.h"
+
+typedef struct DevGenVarArenaChunk_ {
+	struct DevGenVarArenaChunk_ *next;
+	void                        *mem;  /* as returned by malloc */
+} DevGenVarArenaChunk;
+
+static DevGenVarArena    arenaList = 0;
+static epicsMutexId      arenaMtx  = 0;
+static epicsThreadOnceId arenaOnce = EPICS_THREAD_ONCE_INIT;
+
+static void
+arenaInitFn(void *unused)
+{
+	arenaMtx = epicsMutexMustCreate();
+}
+
+#define ALIGN_UP(x, a) ( ((x) + (a) - 1) & ~((size_t)(a) - 1) )
+
+/* Caller holds arenaMtx */
+static int
+arenaGrow(DevGenVarArena a, size_t need)
+{
+DevGenVarArenaChunk *c;
+size_t               sz = a->chunk_size;
+void                *mem;
+char                *base;
+
+	if ( need > sz )
+		sz = ALIGN_UP( need, DEV_GEN_VAR_CACHE_LINE );
+
+	/* chunk header goes in front; data start is cache-line aligned */
+	if ( ! (mem = malloc( sz + sizeof(*c) + DEV_GEN_VAR_CACHE_LINE )) )
+		return -1;
+
+	base    = (char*)ALIGN_UP( (size_t)mem + sizeof(*c), DEV_GEN_VAR_CACHE_LINE );
+	c       = (DevGenVarArenaChunk*)(base - sizeof(*c));
+	c->mem  = mem;
+	c->next = a->chunks;
+
+	a->chunks    = c;
+	a->cur       = base;
+	a->end       = base + sz;
+	a->reserved += sz + sizeof(*c) + DEV_GEN_VAR_CACHE_LINE;
+
+	return 0;
+}
+
+void *
+devGenVarArenaAlloc(DevGenVarArena a, size_t size, size_t align)
+{
+char *rval = 0;
+char *p;
+
+	epicsThreadOnce( &arenaOnce, arenaInitFn, 0 );
+
+	if ( 0 == size )
+		size = 1;
+
+	epicsMutexMustLock( arenaMtx );
+
+		if ( ! a->listed ) {
+			a->next   = arenaList;
+			arenaList = a;
+			a->listed = 1;
+		}
+
+		p = a->cur ? (char*)ALIGN_UP( (size_t)a->cur, align ) : 0;
+
+		if ( ! p || p + size > a->end ) {
+			if ( arenaGrow( a, size ) )
+				goto bail;
+			p = a->cur;
+		}
+
+		a->used += (p + size) - a->cur;
+		a->cur   = p + size;
+		a->n_objs++;
+
+		/* chunks are not zeroed by malloc */
+		memset( p, 0, size );
+		rval = p;
+bail:
+	epicsMutexUnlock( arenaMtx );
+	return rval;
+}
+
+void
+devGenVarArenaRelease(DevGenVarArena a)
+{
+DevGenVarArenaChunk *c;
+
+	epicsThreadOnce( &arenaOnce, arenaInitFn, 0 );
+
+	epicsMutexMustLock( arenaMtx );
+		while ( (c = a->chunks) ) {
+			a->chunks = c->next;
+			free( c->mem );
+		}
+		a->cur      = a->end = 0;
+		a->used     = 0;
+		a->reserved = 0;
+		a->n_objs   = 0;
+	epicsMutexUnlock( arenaMtx );
+}
+
+void
+devGenVarArenaShow(int level)
+{
+DevGenVarArena a;
+DevGenVarArenaChunk *c;
+unsigned       n_chunks;
+size_t         tot_used = 0, tot_res = 0;
+
+	epicsThreadOnce( &arenaOnce, arenaInitFn, 0 );
+
+	epicsMutexMustLock( arenaMtx );
+		printf("%-16s %10s %12s %12s %8s\n", "Arena", "Objects", "Used [B]", "Reserved [B]", "Chunks");
+		for ( a = arenaList; a; a = a->next ) {
+			for ( n_chunks = 0, c = a->chunks; c; c = c->next )
+				n_chunks++;
+			printf("%-16s %10lu %12lu %12lu %8u\n",
+				a->name, a->n_objs, (unsigned long)a->used, (unsigned long)a->reserved, n_chunks);
+			tot_used += a->used;
+			tot_res  += a->reserved;
+		}
+		printf("%-16s %10s %12lu %12lu\n", "Total", "", (unsigned long)tot_used, (unsigned long)tot_res);
+	epicsMutexUnlock( arenaMtx );
+}
@@ -0,0 +1,62 @@
+#ifndef DEV_GEN_VAR_ARENA_H
+#define DEV_GEN_VAR_ARENA_H
+
+/*
+ * Simple arena allocator (devGenVar-internal; not installed).
+ *
+ * Objects are carved out of large, cache-line aligned chunks
+ * and are never freed individually. An entire arena may be
+ * released at once.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DEV_GEN_VAR_CACHE_LINE    64
+#define DEV_GEN_VAR_ARENA_CHUNK   (64*1024)
+
+typedef struct DevGenVarArenaRec_ {
+	const char                 *name;
+	size_t                      chunk_size;
+	struct DevGenVarArenaChunk_ *chunks;
+	char                       *cur, *end;
+	size_t                      used;     /* bytes handed out (incl. padding) */
+	size_t                      reserved; /* bytes obtained from malloc       */
+	unsigned long               n_objs;
+	struct DevGenVarArenaRec_  *next;
+	int                         listed;
+} DevGenVarArenaRec, *DevGenVarArena;
+
+#define DEV_GEN_VAR_ARENA_INIT(nam) \
+	{ name: (nam), chunk_size: DEV_GEN_VAR_ARENA_CHUNK }
+
+/*
+ * Allocate 'size' zeroed bytes aligned to 'align' (which must
+ * be a power of two not bigger than DEV_GEN_VAR_CACHE_LINE).
+ *
+ * RETURNS: pointer or NULL (no memory).
+ */
+void *
+devGenVarArenaAlloc(DevGenVarArena a, size_t size, size_t align);
+
+/*
+ * Release all memory held by an arena; all objects allocated
+ * from it become invalid.
+ */
+void
+devGenVarArenaRelease(DevGenVarArena a);
+
+/*
+ * Print the bytes used by every arena.
+ */
+void
+devGenVarArenaShow(int level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,203 @@
+#ifndef DEV_GEN_VAR_CXX_H
+#define DEV_GEN_VAR_CXX_H
+
+/*
+ * Typed C++ wrapper around a DevGenVarRec (header-only).
+ *
+ * GenVar<T, N> owns a variable of N elements of type T and the
+ * DevGenVarRec describing it. The DBR type is deduced from T at
+ * compile time; unsupported types fail to compile:
+ *
+ *   #include <devGenVarCxx.h>
+ *
+ *   static devGenVar::GenVar<epicsUInt32>     rxBytes;
+ *   static devGenVar::GenVar<epicsInt16, 16>  temps;
+ *
+ *   rxBytes.lockCreate();
+ *   rxBytes.scanPvtCreate();
+ *   rxBytes.registerAs( "rxBytes" );
+ *   ...
+ *   rxBytes.update( n, &now );      // stores; scans if changed
+ *   temps.updateArr( t16, &now );   // all 16 elements
+ *
+ *   {
+ *     devGenVar::GenVar<epicsInt16, 16>::Guard g( temps );
+ *     temps.data()[3] = t;
+ *   }
+ *   temps.scan();
+ *
+ * Records attached to a GenVar whose T matches the record's field
+ * type (e.g., epicsInt32 and a longin VAL) transfer it with a plain
+ * copy; the devsup selects this when the record is initialized.
+ *
+ * update()/updateArr() are inlined for the common case (no deadband,
+ * no snapshot group): they compare (bitwise, like devGenVarUpdate())
+ * and store the value as a T (no dispatch on the DBR type) and request
+ * a scan only if the value changed.
+ *
+ * A GenVar must not be copied or destroyed once it is registered
+ * (see devGenVarRegister()).
+ */
+
+#include <devGenVar.h>
+#include <epicsTypes.h>
+
+namespace devGenVar {
+
+/* Map C types to DBR types; only the specializations exist */
+template <typename T> struct DbrType;
+
+template <> struct DbrType<epicsInt8>    { enum { value = DBR_CHAR   }; };
+template <> struct DbrType<epicsUInt8>   { enum { value = DBR_UCHAR  }; };
+template <> struct DbrType<epicsInt16>   { enum { value = DBR_SHORT  }; };
+template <> struct DbrType<epicsUInt16>  { enum { value = DBR_USHORT }; };
+template <> struct DbrType<epicsInt32>   { enum { value = DBR_LONG   }; };
+template <> struct DbrType<epicsUInt32>  { enum { value = DBR_ULONG  }; };
+template <> struct DbrType<epicsFloat32> { enum { value = DBR_FLOAT  }; };
+template <> struct DbrType<epicsFloat64> { enum { value = DBR_DOUBLE }; };
+#ifdef DBR_INT64
+template <> struct DbrType<epicsInt64>   { enum { value = DBR_INT64  }; };
+template <> struct DbrType<epicsUInt64>  { enum { value = DBR_UINT64 }; };
+#endif
+
+template <typename T, unsigned N = 1>
+class GenVar {
+public:
+	enum { dbr = DbrType<T>::value, nelms = N };
+
+	/* RAII lock */
+	class Guard {
+	public:
+		explicit Guard(GenVar &gv) : gv_( gv ) { gv_.lock();   }
+		~Guard()                               { gv_.unlock(); }
+	private:
+		Guard(const Guard &);
+		Guard &operator=(const Guard &);
+		GenVar &gv_;
+	};
+
+	GenVar()
+	{
+		devGenVarInit( &gv_, 1 );
+		memset( val_, 0, sizeof(val_) );
+		gv_.data_p = val_;
+		gv_.dbr_t  = dbr;
+		gv_.n_elms = N;
+	}
+
+	/* Setup (before iocInit); these return zero on success */
+	long lockCreate()                 { return devGenVarLockCreate( &gv_ );      }
+	long evtCreate()                  { return devGenVarEvtCreate( &gv_ );       }
+	long scanPvtCreate()
+	{
+		DevGenVarRec tmp = gv_;
+		long         st  = devGenVarInitScanPvt( &tmp, 1 );
+
+		/* devGenVarInitScanPvt() re-initializes the record */
+		if ( 0 == st )
+			gv_.scan_p = tmp.scan_p;
+		return st;
+	}
+	void setScanPvt(IOSCANPVT *scan_p) { gv_.scan_p = scan_p;                    }
+	void setOpts(unsigned opts)        { gv_.opts   = opts;                      }
+	long registerAs(const char *name)  { return devGenVarRegister( name, &gv_, 1 ); }
+
+	void lock()                       { devGenVarLock( &gv_ );                   }
+	void unlock()                     { devGenVarUnlock( &gv_ );                 }
+	void scan()                       { devGenVarScan( &gv_ );                   }
+	void markDirty()                  { devGenVarMarkDirty( &gv_ );              }
+	long wait(double timeout = -1.)   { return devGenVarWait( &gv_, timeout );   }
+
+	/* Direct access; hold the lock */
+	T          *data()                { return val_;                             }
+	const T    *data() const          { return val_;                             }
+
+	/* Locked element access */
+	T get(unsigned i = 0)
+	{
+		Guard g( *this );
+		return val_[i];
+	}
+
+	void set(T v, unsigned i = 0)
+	{
+		Guard g( *this );
+		val_[i] = v;
+		devGenVarMarkDirty( &gv_ );
+	}
+
+	void setStatus(epicsEnum16 stat, epicsEnum16 sevr, const epicsTimeStamp *ts = 0)
+	{
+		Guard g( *this );
+		gv_.stat = stat;
+		gv_.sevr = sevr;
+		if ( ts )
+			gv_.ts = *ts;
+	}
+
+	/* Same semantics as devGenVarUpdate(); 'v' holds N elements */
+	long updateArr(const T *v, const epicsTimeStamp *ts = 0)
+	{
+		bool     changed = false;
+		unsigned i;
+
+		if ( gv_.deadband > 0. || gv_.snap )
+			return devGenVarUpdate( &gv_, v, ts );
+
+		if ( (gv_.opts & DEV_GEN_VAR_OPT_SEQLOCK) )
+			devGenVarSeqBegin( &gv_ );
+		else
+			lock();
+
+		for ( i = 0; i < N; i++ ) {
+			/* bitwise: NaN is not 'changed' every time */
+			if ( memcmp( &val_[i], &v[i], sizeof(T) ) ) {
+				changed = true;
+				val_[i] = v[i];
+			}
+		}
+		/* the first update always scans */
+		if ( ! gv_.upd_valid ) {
+			changed       = true;
+			gv_.upd_valid = 1;
+		}
+		if ( ts )
+			gv_.ts = *ts;
+
+		if ( (gv_.opts & DEV_GEN_VAR_OPT_SEQLOCK) )
+			devGenVarSeqEndNoMark( &gv_ );
+		else
+			unlock();
+
+		if ( ! changed ) {
+			__atomic_fetch_add( &gv_.n_supp, 1, __ATOMIC_RELAXED );
+			return 0;
+		}
+
+		devGenVarMarkDirty( &gv_ );
+		scan();
+		return 1;
+	}
+
+	/* Scalars only */
+	long update(T v, const epicsTimeStamp *ts = 0)
+	{
+		typedef char scalar_update_needs_N_equal_1[ 1 == N ? 1 : -1 ];
+		(void)sizeof(scalar_update_needs_N_equal_1);
+		return updateArr( &v, ts );
+	}
+
+	/* For the C API */
+	DevGenVar   raw()                 { return &gv_;                             }
+
+private:
+	GenVar(const GenVar &);
+	GenVar &operator=(const GenVar &);
+
+	DevGenVarRec gv_;
+	T            val_[N];
+};
+
+} /* namespace devGenVar */
+
+#endif
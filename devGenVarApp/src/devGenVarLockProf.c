@@ -0,0 +1,262 @@
+#include <epicsMutex.h>
+#include <epicsTime.h>
+#include <epicsVersion.h>
+#include <epicsExport.h>
+#include <errlog.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "devGenVar.h"
+#include "devGenVarReg.h"
+
+/* Instrumented locking.
+ *
+ * While 'devGenVarLockProf' is nonzero, devGenVarLock() & friends
+ * record, for every mutex, how long threads wait to acquire it
+ * and how long they hold it. Times go into log2 histograms (in
+ * nanoseconds). Statistics are kept per mutex, i.e., a mutex which
+ * is shared by many GenVars shows up once.
+ *
+ * Entries live in a fixed-size table keyed by the mutex pointer.
+ * New keys are claimed with a CAS so that no lock is needed for
+ * lookup/insertion; all other updates of an entry happen while
+ * holding the respective mutex.
+ */
+
+#if EPICS_VERSION > 3
+#define HAVE_EPICS_MONOTONIC
+#endif
+
+#define LOCK_PROF_LD_SIZE   10
+#define LOCK_PROF_SIZE      (1 << LOCK_PROF_LD_SIZE)
+#define LOCK_PROF_NBINS     32
+
+int devGenVarLockProf = 0;
+epicsExportAddress(int, devGenVarLockProf);
+
+/* # of mutexes currently held with depth > 0; while nonzero the unlock
+ * path goes through devGenVarLockProfUnlock() so that 'depth' is
+ * dropped even if profiling was switched off while a mutex was held.
+ */
+unsigned devGenVarLockProfHeld = 0;
+
+typedef struct LockProfHist_ {
+	unsigned long   n;
+	epicsUInt64     tot, max;      /* ns */
+	unsigned long   bin[LOCK_PROF_NBINS];
+} LockProfHist;
+
+typedef struct LockProfRec_ {
+	DevGenVarMtx    mtx;
+	unsigned        depth;         /* EPICS mutexes are recursive */
+	epicsUInt64     t_acq;
+	unsigned long   n_cont;        /* acquisitions which had to wait */
+	LockProfHist    wait;
+	LockProfHist    hold;
+} LockProfRec, *LockProf;
+
+static LockProfRec   lockProfTbl[LOCK_PROF_SIZE];
+static unsigned long lockProfLost = 0;  /* table full */
+
+static __inline__ epicsUInt64
+nsNow()
+{
+#ifdef HAVE_EPICS_MONOTONIC
+	return epicsMonotonicGet();
+#else
+epicsTimeStamp ts;
+	epicsTimeGetCurrent( &ts );
+	return (epicsUInt64)ts.secPastEpoch * 1000000000ULL + ts.nsec;
+#endif
+}
+
+/* Find the entry for 'mtx'; claim a free one if 'create' is nonzero */
+static LockProf
+lockProfFind(DevGenVarMtx mtx, int create)
+{
+unsigned     i, n;
+DevGenVarMtx k;
+
+	i = (unsigned)(((size_t)mtx >> 4) * 2654435761U) & (LOCK_PROF_SIZE - 1);
+
+	for ( n = 0; n < LOCK_PROF_SIZE; n++ ) {
+		k = __atomic_load_n( &lockProfTbl[i].mtx, __ATOMIC_ACQUIRE );
+		if ( k == mtx )
+			return &lockProfTbl[i];
+		if ( ! k ) {
+			if ( ! create )
+				return 0;
+			if ( __atomic_compare_exchange_n( &lockProfTbl[i].mtx, &k, mtx, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) )
+				return &lockProfTbl[i];
+			if ( k == mtx )
+				return &lockProfTbl[i];
+		}
+		i = (i + 1) & (LOCK_PROF_SIZE - 1);
+	}
+	if ( create )
+		__atomic_fetch_add( &lockProfLost, 1, __ATOMIC_RELAXED );
+	return 0;
+}
+
+/* Caller holds the mutex */
+static void
+histAdd(LockProfHist *h, epicsUInt64 dt)
+{
+unsigned b = 0;
+epicsUInt64 v;
+
+	for ( v = dt; v > 1 && b < LOCK_PROF_NBINS - 1; v >>= 1 )
+		b++;
+
+	__atomic_store_n( &h->n,      h->n + 1,      __ATOMIC_RELAXED );
+	__atomic_store_n( &h->tot,    h->tot + dt,   __ATOMIC_RELAXED );
+	__atomic_store_n( &h->bin[b], h->bin[b] + 1, __ATOMIC_RELAXED );
+	if ( dt > h->max )
+		__atomic_store_n( &h->max, dt, __ATOMIC_RELAXED );
+}
+
+void
+devGenVarLockProfLock(DevGenVarMtx mtx)
+{
+LockProf    p;
+epicsUInt64 t0, t1;
+
+	if ( epicsMutexLockOK == epicsMutexTryLock( mtx ) ) {
+		t0 = t1 = nsNow();
+		if ( ! (p = lockProfFind( mtx, 1 )) )
+			return;
+	} else {
+		t0 = nsNow();
+		epicsMutexMustLock( mtx );
+		t1 = nsNow();
+		if ( ! (p = lockProfFind( mtx, 1 )) )
+			return;
+		__atomic_store_n( &p->n_cont, p->n_cont + 1, __ATOMIC_RELAXED );
+	}
+
+	if ( 0 == p->depth++ ) {
+		__atomic_fetch_add( &devGenVarLockProfHeld, 1, __ATOMIC_RELAXED );
+		histAdd( &p->wait, t1 - t0 );
+		p->t_acq = t1;
+	}
+}
+
+void
+devGenVarLockProfUnlock(DevGenVarMtx mtx)
+{
+LockProf p;
+
+	/* Lock may have been taken before profiling was switched on */
+	if ( (p = lockProfFind( mtx, 0 )) && p->depth > 0 && 0 == --p->depth ) {
+		/* recorded even if profiling has been switched off meanwhile */
+		histAdd( &p->hold, nsNow() - p->t_acq );
+		__atomic_fetch_sub( &devGenVarLockProfHeld, 1, __ATOMIC_RELAXED );
+	}
+	epicsMutexUnlock( mtx );
+}
+
+/* Find the GenVars using a mutex */
+typedef struct LockProfUsers_ {
+	DevGenVarMtx    mtx;
+	int             n;
+	const char     *name;
+	int             idx;
+} LockProfUsers;
+
+static int
+lockProfUsers(RegHead h, void *arg)
+{
+LockProfUsers *u = arg;
+int            i;
+
+	for ( i = 0; i < h->n_entries; i++ ) {
+		if ( h->gv[i].mtx == u->mtx ) {
+			if ( 0 == u->n++ ) {
+				u->name = h->name;
+				u->idx  = i;
+			}
+		}
+	}
+	return 0;
+}
+
+static int
+cmpWaitTot(const void *a, const void *b)
+{
+epicsUInt64 ta = (*(const LockProf*)a)->wait.tot;
+epicsUInt64 tb = (*(const LockProf*)b)->wait.tot;
+
+	return ta > tb ? -1 : ( ta < tb ? 1 : 0 );
+}
+
+static void
+histShow(const char *nm, LockProfHist *h)
+{
+unsigned b;
+
+	printf("    %s histogram (bin: >= 2^bin ns):\n", nm);
+	for ( b = 0; b < LOCK_PROF_NBINS; b++ ) {
+		if ( h->bin[b] )
+			printf("      %2u: %10lu\n", b, h->bin[b]);
+	}
+}
+
+void
+devGenVarLockShow(int n_top, int level)
+{
+LockProf     *l;
+unsigned      i, n;
+LockProfUsers u;
+LockProf      p;
+
+	if ( ! (l = malloc( sizeof(*l) * LOCK_PROF_SIZE )) ) {
+		errlogPrintf("devGenVarLockShow: no memory\n");
+		return;
+	}
+
+	for ( i = n = 0; i < LOCK_PROF_SIZE; i++ ) {
+		if ( __atomic_load_n( &lockProfTbl[i].mtx, __ATOMIC_ACQUIRE ) )
+			l[n++] = &lockProfTbl[i];
+	}
+
+	qsort( l, n, sizeof(l[0]), cmpWaitTot );
+
+	if ( n_top <= 0 || (unsigned)n_top > n )
+		n_top = n;
+
+	printf("Lock profiling is %s; %u mutexes seen", devGenVarLockProf ? "ON" : "OFF", n);
+	if ( lockProfLost )
+		printf(" (%lu acquisitions not recorded; table full)", lockProfLost);
+	printf("\n");
+	printf("%-28s %5s %10s %10s %12s %12s %12s %12s\n",
+		"GenVar[idx] (first user)", "Users", "Locks", "Contended",
+		"Wait avg/ns", "Wait max/ns", "Hold avg/ns", "Hold max/ns");
+
+	for ( i = 0; i < (unsigned)n_top; i++ ) {
+		p     = l[i];
+		u.mtx = p->mtx;
+		u.n   = 0;
+		devGenVarRegForEach( lockProfUsers, &u );
+
+		if ( u.n > 0 )
+			printf("%-23s[%3i]", u.name, u.idx);
+		else
+			printf("%-28p", (void*)p->mtx);
+
+		printf(" %5i %10lu %10lu %12.0f %12llu %12.0f %12llu\n",
+			u.n, p->wait.n, p->n_cont,
+			p->wait.n ? (double)p->wait.tot/(double)p->wait.n : 0.,
+			(unsigned long long)p->wait.max,
+			p->hold.n ? (double)p->hold.tot/(double)p->hold.n : 0.,
+			(unsigned long long)p->hold.max);
+
+		if ( level > 0 ) {
+			histShow( "wait", &p->wait );
+			histShow( "hold", &p->hold );
+		}
+	}
+
+	free( l );
+}
@@ -0,0 +1,272 @@
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <errlog.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "devGenVarReg.h"
+
+/* Registry hash table.
+ *
+ * Open addressing with linear probing. When the load factor exceeds
+ * REG_MAX_LOAD a table of twice the size becomes 'current' and the
+ * entries of the 'old' table are copied over a few slots at a time
+ * by subsequent additions (REG_MIGRATE_STEP). The old table is never
+ * modified and never freed so that a concurrent lookup may safely
+ * finish searching it. Lookups search the current and then the old
+ * table; they retry if a new resize started in the meantime.
+ */
+
+#define REG_LD_SIZE_INIT  8
+#define REG_MAX_LOAD      0.5
+#define REG_MIGRATE_STEP  8
+
+typedef struct RegTblRec_ {
+	unsigned   mask;    /* size - 1 */
+	RegHead    slot[];
+} RegTblRec, *RegTbl;
+
+static RegTbl            regCur   = 0;
+static RegTbl            regOld   = 0;
+static unsigned          regGen   = 0; /* odd while switching tables */
+static unsigned          regMig   = 0; /* next 'old' slot to migrate  */
+static unsigned          regUsed  = 0;
+static epicsMutexId      regMtx   = 0;
+
+/* Statistics */
+static unsigned long     regNLookups = 0;
+static unsigned long     regNProbes  = 0;
+static unsigned long     regNResize  = 0;
+static unsigned          regMaxProbe = 0;
+
+static epicsThreadOnceId regOnce = EPICS_THREAD_ONCE_INIT;
+
+static unsigned
+regHash(const char *name)
+{
+unsigned h = 2166136261U; /* FNV-1a */
+
+	while ( *name ) {
+		h ^= (unsigned char)*name++;
+		h *= 16777619U;
+	}
+	return h;
+}
+
+static RegTbl
+regTblCreate(unsigned size)
+{
+RegTbl t;
+
+	if ( ! (t = calloc( 1, sizeof(*t) + size * sizeof(t->slot[0]) )) )
+		return 0;
+	t->mask = size - 1;
+	return t;
+}
+
+static void
+regInitFn(void *unused)
+{
+	regMtx = epicsMutexMustCreate();
+	if ( ! (regCur = regTblCreate( 1 << REG_LD_SIZE_INIT )) )
+		errlogPrintf("devGenVar: Unable to create registry\n");
+}
+
+void
+devGenVarRegInit(void)
+{
+	epicsThreadOnce( &regOnce, regInitFn, 0 );
+}
+
+static RegHead
+regTblFind(RegTbl t, const char *name, unsigned hash, unsigned *probes)
+{
+unsigned i = hash & t->mask;
+RegHead  h;
+
+	while ( (h = __atomic_load_n( &t->slot[i], __ATOMIC_ACQUIRE )) ) {
+		++*probes;
+		if ( h->hash == hash && 0 == strcmp( h->name, name ) )
+			return h;
+		i = (i + 1) & t->mask;
+	}
+	return 0;
+}
+
+/* Caller holds regMtx */
+static void
+regTblInsert(RegTbl t, RegHead h)
+{
+unsigned i = h->hash & t->mask;
+
+	while ( t->slot[i] )
+		i = (i + 1) & t->mask;
+	__atomic_store_n( &t->slot[i], h, __ATOMIC_RELEASE );
+}
+
+/* Copy up to 'n' slots of the old table; caller holds regMtx */
+static void
+regMigrate(unsigned n)
+{
+unsigned probes;
+
+	while ( regOld && n-- > 0 ) {
+		if ( regOld->slot[regMig] ) {
+			probes = 0;
+			if ( ! regTblFind( regCur, regOld->slot[regMig]->name, regOld->slot[regMig]->hash, &probes ) )
+				regTblInsert( regCur, regOld->slot[regMig] );
+		}
+		if ( ++regMig > regOld->mask ) {
+			/* done; lookups no longer need the old table */
+			__atomic_store_n( &regOld, 0, __ATOMIC_RELEASE );
+		}
+	}
+}
+
+int
+devGenVarRegAdd(RegHead h)
+{
+RegTbl   t;
+unsigned probes = 0;
+int      rval   = -1;
+
+	devGenVarRegInit();
+
+	if ( ! regCur )
+		return -1;
+
+	h->hash = regHash( h->name );
+
+	epicsMutexMustLock( regMtx );
+
+	if ( regTblFind( regCur, h->name, h->hash, &probes ) || (regOld && regTblFind( regOld, h->name, h->hash, &probes )) )
+		goto bail;
+
+	regMigrate( REG_MIGRATE_STEP );
+
+	if ( (double)(regUsed + 1) > REG_MAX_LOAD * (regCur->mask + 1) ) {
+		/* Still migrating from the last resize; finish that first */
+		regMigrate( regOld ? regOld->mask + 1 : 0 );
+
+		if ( ! (t = regTblCreate( 2 * (regCur->mask + 1) )) ) {
+			errlogPrintf("devGenVarRegister: no memory for growing registry\n");
+			goto bail;
+		}
+		__atomic_add_fetch( &regGen, 1, __ATOMIC_SEQ_CST );
+			__atomic_store_n( &regOld, regCur, __ATOMIC_RELEASE );
+			__atomic_store_n( &regCur, t,      __ATOMIC_RELEASE );
+			regMig = 0;
+		__atomic_add_fetch( &regGen, 1, __ATOMIC_SEQ_CST );
+		regNResize++;
+	}
+
+	regTblInsert( regCur, h );
+	regUsed++;
+	rval = 0;
+
+bail:
+	epicsMutexUnlock( regMtx );
+	return rval;
+}
+
+RegHead
+devGenVarRegFind(const char *name)
+{
+unsigned hash, gen, probes = 0;
+RegTbl   c, o;
+RegHead  h;
+unsigned m;
+
+	/* No epicsThreadOnce() here (it takes a global lock); the registry
+	 * was created by the registrar or by the first devGenVarRegAdd().
+	 */
+	if ( ! name || ! __atomic_load_n( &regCur, __ATOMIC_ACQUIRE ) )
+		return 0;
+
+	hash = regHash( name );
+
+	do {
+		while ( (gen = __atomic_load_n( &regGen, __ATOMIC_ACQUIRE )) & 1 )
+			/* tables being switched */;
+
+		c = __atomic_load_n( &regCur, __ATOMIC_ACQUIRE );
+		o = __atomic_load_n( &regOld, __ATOMIC_ACQUIRE );
+
+		if ( ! (h = regTblFind( c, name, hash, &probes )) && o )
+			h = regTblFind( o, name, hash, &probes );
+
+	} while ( ! h && gen != __atomic_load_n( &regGen, __ATOMIC_ACQUIRE ) );
+
+	__atomic_fetch_add( &regNLookups, 1,      __ATOMIC_RELAXED );
+	__atomic_fetch_add( &regNProbes,  probes, __ATOMIC_RELAXED );
+	m = __atomic_load_n( &regMaxProbe, __ATOMIC_RELAXED );
+	while ( probes > m && ! __atomic_compare_exchange_n( &regMaxProbe, &m, probes, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+		/* 'm' was reloaded; retry */;
+
+	return h;
+}
+
+void
+devGenVarRegForEach(int (*fn)(RegHead h, void *arg), void *arg)
+{
+unsigned i, probes;
+
+	epicsThreadOnce( &regOnce, regInitFn, 0 );
+
+	if ( ! regCur )
+		return;
+
+	epicsMutexMustLock( regMtx );
+		for ( i = 0; i <= regCur->mask; i++ ) {
+			if ( regCur->slot[i] && fn( regCur->slot[i], arg ) )
+				goto bail;
+		}
+		/* entries not migrated yet */
+		for ( i = 0; regOld && i <= regOld->mask; i++ ) {
+			probes = 0;
+			if (    regOld->slot[i]
+			     && ! regTblFind( regCur, regOld->slot[i]->name, regOld->slot[i]->hash, &probes )
+			     && fn( regOld->slot[i], arg ) )
+				goto bail;
+		}
+bail:
+	epicsMutexUnlock( regMtx );
+}
+
+void
+devGenVarRegShow(int level)
+{
+unsigned size, i, len, maxLen = 0, nChains = 0;
+unsigned long sumLen = 0;
+
+	epicsThreadOnce( &regOnce, regInitFn, 0 );
+
+	if ( ! regCur )
+		return;
+
+	epicsMutexMustLock( regMtx );
+		size = regCur->mask + 1;
+		if ( level > 0 ) {
+			/* probe length needed to reach every entry */
+			for ( i = 0; i < size; i++ ) {
+				if ( ! regCur->slot[i] )
+					continue;
+				len = ((i - regCur->slot[i]->hash) & regCur->mask) + 1;
+				sumLen += len;
+				nChains++;
+				if ( len > maxLen )
+					maxLen = len;
+			}
+		}
+		printf("devGenVar registry: %u entries, %u slots, load factor %.2f, %lu resizes%s\n",
+			regUsed, size, (double)regUsed/(double)size, regNResize, regOld ? " (migrating)" : "");
+		printf("  lookups: %lu, probes/lookup: %.2f, max. probes: %u\n",
+			regNLookups, regNLookups ? (double)regNProbes/(double)regNLookups : 0., regMaxProbe);
+		if ( level > 0 && nChains ) {
+			printf("  current table: avg. probe length %.2f, max. %u\n",
+				(double)sumLen/(double)nChains, maxLen);
+		}
+	epicsMutexUnlock( regMtx );
+}
@@ -0,0 +1,69 @@
+#ifndef DEV_GEN_VAR_REG_H
+#define DEV_GEN_VAR_REG_H
+
+/*
+ * Registry of DevGenVarRec arrays (devGenVar-internal; not installed).
+ *
+ * The registry is an open-addressing hash table which grows by itself
+ * (the contents are migrated incrementally while new entries are added).
+ * Adding entries is serialized by a mutex but lookups never lock.
+ */
+
+#include <devGenVar.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct RegHeadRec_ {
+	DevGenVar  gv;
+	int        n_entries;
+	unsigned   hash;
+	const DevGenVarMemberRec *members;   /* struct layout (or NULL) */
+	int        n_members;
+	char       name[];
+} RegHeadRec, *RegHead;
+
+/*
+ * Create the (empty) registry; called by the registrar and by
+ * devGenVarRegAdd(). Lookups return NULL until this has been done.
+ */
+void
+devGenVarRegInit(void);
+
+/*
+ * Add an entry. 'h->name' must be set; 'h->hash' is computed by
+ * this routine. The registry keeps a reference to 'h'.
+ *
+ * RETURNS: zero on success, nonzero if the name is already registered
+ *          (or no memory).
+ */
+int
+devGenVarRegAdd(RegHead h);
+
+/*
+ * Find an entry by name; never blocks.
+ *
+ * RETURNS: entry or NULL if not found.
+ */
+RegHead
+devGenVarRegFind(const char *name);
+
+/*
+ * Call 'fn' for every entry (in no particular order) until it returns
+ * nonzero.
+ */
+void
+devGenVarRegForEach(int (*fn)(RegHead h, void *arg), void *arg);
+
+/*
+ * Print size, load factor and probe statistics.
+ */
+void
+devGenVarRegShow(int level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,388 @@
+/* Micro-benchmark for the devGenVarGet()/devGenVarPut() hot path.
+ *
+ * Builds an in-process IOC with synthetic records (created with
+ * dbStaticLib; no database file needed), then calls the device-
+ * support's read/write routines directly from 1..N threads for every
+ * combination of
+ *   - record field type (DBF) and GenVar type (DBR),
+ *   - with/without mutex,
+ *   - with/without event.
+ *
+ * The DBF side covers every record type/field devGenVar supports
+ * (raw and converted fields, every FTVL of the array records); the
+ * DBR side every GenVar type (DBR_STRING .. DBR_ENUM, DBR_INT64 and
+ * DBR_UINT64 where available). Record types not present in the
+ * EPICS base in use (int64in/out, lsi/lso) are skipped.
+ *
+ * Results are written as CSV (one line per combination) to stdout
+ * (following the IOC's startup messages) or to a file (-o):
+ *
+ *   rec,dbf,dbr,nelm,mtx,evt,threads,ops,ns_per_op,ops_per_s
+ *
+ * 'ns_per_op' is the wall-clock time one thread needs for one
+ * operation; 'ops_per_s' is the aggregate throughput of all threads.
+ *
+ * Usage: genVarBench [-t max_threads] [-n iterations] [-e nelm] [-d dbd_file] [-o csv_file]
+ *        (run from <top> or specify the path to genVarBench.dbd)
+ */
+#include <epicsExit.h>
+#include <epicsThread.h>
+#include <epicsEvent.h>
+#include <epicsTime.h>
+#include <epicsTypes.h>
+#include <epicsStdio.h>
+#include <dbAccess.h>
+#include <devSup.h>
+#include <dbStaticLib.h>
+#include <dbFldTypes.h>
+#include <iocInit.h>
+#include <errlog.h>
+#include <epicsVersion.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <devGenVar.h>
+#include <devGenVarSup.h>
+
+extern int genVarBench_registerRecordDeviceDriver(struct dbBase *pdbbase);
+
+#define MAX_THREADS 64
+
+/* Record configurations; 'sig' selects raw vs. converted field */
+typedef struct BenchCfg_ {
+	const char *rec;
+	const char *dbf;   /* field type (FTVL for arrays) */
+	int         sig;
+	int         out;
+	int         arr;
+} BenchCfg;
+
+#if defined(EPICS_VERSION_INT) && EPICS_VERSION_INT >= VERSION_INT(3,15,0,2)
+#define HAVE_LSI_LSO
+#endif
+
+#ifdef DBR_INT64
+#define ARR_CFGS_INT64(rec, out) \
+	{ rec, "INT64",  0, out, 1 }, \
+	{ rec, "UINT64", 0, out, 1 },
+#else
+#define ARR_CFGS_INT64(rec, out)
+#endif
+
+/* Every FTVL */
+#define ARR_CFGS(rec, out) \
+	{ rec, "STRING", 0, out, 1 }, \
+	{ rec, "CHAR",   0, out, 1 }, \
+	{ rec, "UCHAR",  0, out, 1 }, \
+	{ rec, "SHORT",  0, out, 1 }, \
+	{ rec, "USHORT", 0, out, 1 }, \
+	{ rec, "LONG",   0, out, 1 }, \
+	{ rec, "ULONG",  0, out, 1 }, \
+	{ rec, "FLOAT",  0, out, 1 }, \
+	{ rec, "DOUBLE", 0, out, 1 }, \
+	{ rec, "ENUM",   0, out, 1 }, \
+	ARR_CFGS_INT64(rec, out)
+
+static BenchCfg cfgs[] = {
+	{ "ai",        "LONG",   0, 0, 0 }, /* RVAL */
+	{ "ai",        "DOUBLE", 1, 0, 0 }, /* VAL  */
+	{ "longin",    "LONG",   0, 0, 0 },
+	{ "bi",        "ULONG",  0, 0, 0 }, /* RVAL */
+	{ "bi",        "ENUM",   1, 0, 0 }, /* VAL  */
+	{ "mbbi",      "ULONG",  0, 0, 0 },
+	{ "mbbi",      "ENUM",   1, 0, 0 },
+	{ "stringin",  "STRING", 0, 0, 0 },
+#ifdef HAVE_LSI_LSO
+	{ "lsi",       "STRING", 0, 0, 0 },
+#endif
+#ifdef DBR_INT64
+	{ "int64in",   "INT64",  0, 0, 0 },
+#endif
+	ARR_CFGS( "waveform", 0 )
+	ARR_CFGS( "aai",      0 )
+	{ "ao",        "LONG",   0, 1, 0 },
+	{ "ao",        "DOUBLE", 1, 1, 0 },
+	{ "longout",   "LONG",   0, 1, 0 },
+	{ "bo",        "ULONG",  0, 1, 0 }, /* RVAL only */
+	{ "mbbo",      "ULONG",  0, 1, 0 },
+	{ "stringout", "STRING", 0, 1, 0 },
+#ifdef HAVE_LSI_LSO
+	{ "lso",       "STRING", 0, 1, 0 },
+#endif
+#ifdef DBR_INT64
+	{ "int64out",  "INT64",  0, 1, 0 },
+#endif
+	ARR_CFGS( "aao",      1 )
+};
+
+#define N_CFGS (sizeof(cfgs)/sizeof(cfgs[0]))
+
+typedef struct BenchDbr_ {
+	const char *name;
+	unsigned    dbr_t;
+} BenchDbr;
+
+static BenchDbr dbrs[] = {
+	{ "STRING", DBR_STRING },
+	{ "CHAR",   DBR_CHAR   },
+	{ "UCHAR",  DBR_UCHAR  },
+	{ "SHORT",  DBR_SHORT  },
+	{ "USHORT", DBR_USHORT },
+	{ "LONG",   DBR_LONG   },
+	{ "ULONG",  DBR_ULONG  },
+	{ "FLOAT",  DBR_FLOAT  },
+	{ "DOUBLE", DBR_DOUBLE },
+	{ "ENUM",   DBR_ENUM   },
+#ifdef DBR_INT64
+	{ "INT64",  DBR_INT64  },
+	{ "UINT64", DBR_UINT64 },
+#endif
+};
+
+#define N_DBRS (sizeof(dbrs)/sizeof(dbrs[0]))
+
+/* GenVar index: bit 0 -> event, bit 1 -> mutex */
+#define N_VARIANTS 4
+
+static FILE *out        = 0;
+static int   maxThreads = 4;
+static long  iterations = 100000;
+static int   nelm       = 16;
+
+static DevGenVarRec gvs[N_CFGS][N_DBRS][N_VARIANTS];
+
+/* Common part of all devGenVar dsets */
+typedef struct BenchDset_ {
+	long         number;
+	DEVSUPFUN    report;
+	DEVSUPFUN    init;
+	DEVSUPFUN    init_record;
+	DEVSUPFUN    get_ioint_info;
+	DEVSUPFUN    read_write;
+} BenchDset;
+
+typedef struct BenchThr_ {
+	dbCommon     *prec;
+	long        (*fn)(dbCommon*);
+	epicsEventId  go;
+	epicsEventId  done;
+} BenchThr;
+
+static BenchThr thr[MAX_THREADS];
+
+static void
+benchThread(void *arg)
+{
+BenchThr *t = arg;
+long      i;
+
+	while ( 1 ) {
+		epicsEventMustWait( t->go );
+		for ( i = 0; i < iterations; i++ )
+			t->fn( t->prec );
+		epicsEventSignal( t->done );
+	}
+}
+
+static void
+recName(char *buf, size_t sz, unsigned c, unsigned d, int v, int t)
+{
+	epicsSnprintf( buf, sz, "bench:%s:%u:%s:%i:%i", cfgs[c].rec, c, dbrs[d].name, v, t );
+}
+
+static int
+createRecords()
+{
+DBENTRY  ent;
+unsigned c, d;
+int      v, t;
+char     nm[100], lnk[100], val[20];
+long     st = 0;
+
+	dbInitEntry( pdbbase, &ent );
+
+	for ( c = 0; c < N_CFGS; c++ ) {
+		if ( dbFindRecordType( &ent, cfgs[c].rec ) ) {
+			errlogPrintf("genVarBench: record type '%s' not available\n", cfgs[c].rec);
+			continue;
+		}
+		for ( d = 0; d < N_DBRS; d++ ) {
+			for ( v = 0; v < N_VARIANTS; v++ ) {
+				epicsSnprintf( lnk, sizeof(lnk), "C%i S%i @bench_%u_%u", v, cfgs[c].sig, c, d );
+				for ( t = 0; t < maxThreads; t++ ) {
+					recName( nm, sizeof(nm), c, d, v, t );
+					st  = dbCreateRecord( &ent, nm );
+					st |= dbFindField( &ent, "DTYP" ) || dbPutString( &ent, "GenVar" );
+					st |= dbFindField( &ent, cfgs[c].out ? "OUT" : "INP" ) || dbPutString( &ent, lnk );
+					if ( cfgs[c].arr ) {
+						epicsSnprintf( val, sizeof(val), "%i", nelm );
+						st |= dbFindField( &ent, "FTVL" ) || dbPutString( &ent, cfgs[c].dbf );
+						st |= dbFindField( &ent, "NELM" ) || dbPutString( &ent, val );
+					}
+					if ( st ) {
+						errlogPrintf("genVarBench: unable to create record #%i of %s/%s\n", t, cfgs[c].rec, dbrs[d].name);
+						goto bail;
+					}
+				}
+			}
+		}
+	}
+
+bail:
+	dbFinishEntry( &ent );
+	return st ? -1 : 0;
+}
+
+static int
+createGenVars()
+{
+unsigned c, d;
+int      v, i, ne;
+char     nm[100];
+void    *buf;
+long     esz;
+
+	for ( c = 0; c < N_CFGS; c++ ) {
+		for ( d = 0; d < N_DBRS; d++ ) {
+			devGenVarInit( gvs[c][d], N_VARIANTS );
+			for ( v = 0; v < N_VARIANTS; v++ ) {
+				ne  = cfgs[c].arr ? nelm : 1;
+				esz = dbValueSize( dbrs[d].dbr_t );
+				if ( ! (buf = calloc( ne, esz )) )
+					return -1;
+				if ( DBR_STRING == dbrs[d].dbr_t ) {
+					/* a valid number for the numeric fields */
+					for ( i = 0; i < ne; i++ )
+						strcpy( (char*)buf + i * esz, "0" );
+				}
+				gvs[c][d][v].data_p = buf;
+				gvs[c][d][v].dbr_t  = dbrs[d].dbr_t;
+				gvs[c][d][v].n_elms = ne;
+				if ( (v & 2) && devGenVarLockCreate( &gvs[c][d][v] ) )
+					return -1;
+				if ( (v & 1) && devGenVarEvtCreate( &gvs[c][d][v] ) )
+					return -1;
+			}
+			epicsSnprintf( nm, sizeof(nm), "bench_%u_%u", c, d );
+			if ( devGenVarRegister( nm, gvs[c][d], N_VARIANTS ) )
+				return -1;
+		}
+	}
+	return 0;
+}
+
+static void
+runBench()
+{
+unsigned       c, d;
+int            v, t, n;
+char           nm[100];
+DBADDR         addr;
+epicsTimeStamp t0, t1;
+double         dt;
+
+	for ( t = 0; t < maxThreads; t++ ) {
+		thr[t].go   = epicsEventMustCreate( epicsEventEmpty );
+		thr[t].done = epicsEventMustCreate( epicsEventEmpty );
+		epicsThreadMustCreate( "genVarBench",
+		                       epicsThreadPriorityMedium,
+		                       epicsThreadGetStackSize( epicsThreadStackSmall ),
+		                       benchThread,
+		                       &thr[t] );
+	}
+
+	fprintf(out, "rec,dbf,dbr,nelm,mtx,evt,threads,ops,ns_per_op,ops_per_s\n");
+
+	for ( c = 0; c < N_CFGS; c++ ) {
+		for ( d = 0; d < N_DBRS; d++ ) {
+			for ( v = 0; v < N_VARIANTS; v++ ) {
+				for ( n = 1; n <= maxThreads; n++ ) {
+
+					for ( t = 0; t < n; t++ ) {
+						recName( nm, sizeof(nm), c, d, v, t );
+						if ( dbNameToAddr( nm, &addr ) || ! addr.precord->dpvt || ! addr.precord->dset )
+							goto skip;
+						/* the record's read/write routine (e.g., masked write for bo/mbbo) */
+						thr[t].prec = addr.precord;
+						thr[t].fn   = (long (*)(dbCommon*))((BenchDset*)addr.precord->dset)->read_write;
+					}
+
+					epicsTimeGetCurrent( &t0 );
+					for ( t = 0; t < n; t++ )
+						epicsEventSignal( thr[t].go );
+					for ( t = 0; t < n; t++ )
+						epicsEventMustWait( thr[t].done );
+					epicsTimeGetCurrent( &t1 );
+
+					dt = epicsTimeDiffInSeconds( &t1, &t0 );
+
+					fprintf(out, "%s,%s,%s,%i,%i,%i,%i,%ld,%.2f,%.0f\n",
+						cfgs[c].rec, cfgs[c].dbf, dbrs[d].name,
+						cfgs[c].arr ? nelm : 1,
+						(v & 2) ? 1 : 0, (v & 1) ? 1 : 0,
+						n, iterations * n,
+						dt * 1.0E9 / (double)iterations,
+						(double)iterations * n / dt);
+					fflush( out );
+skip:
+					;
+				}
+			}
+		}
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+const char *dbd = "dbd/genVarBench.dbd";
+int         i;
+
+	for ( i = 1; i < argc - 1; i += 2 ) {
+		if      ( 0 == strcmp( argv[i], "-t" ) )
+			maxThreads = atoi( argv[i+1] );
+		else if ( 0 == strcmp( argv[i], "-n" ) )
+			iterations = atol( argv[i+1] );
+		else if ( 0 == strcmp( argv[i], "-e" ) )
+			nelm       = atoi( argv[i+1] );
+		else if ( 0 == strcmp( argv[i], "-d" ) )
+			dbd        = argv[i+1];
+		else if ( 0 == strcmp( argv[i], "-o" ) ) {
+			if ( ! (out = fopen( argv[i+1], "w" )) ) {
+				fprintf(stderr, "Unable to open %s\n", argv[i+1]);
+				return 1;
+			}
+		} else
+			break;
+	}
+	if ( i < argc || maxThreads < 1 || maxThreads > MAX_THREADS || iterations < 1 || nelm < 1 ) {
+		fprintf(stderr, "Usage: %s [-t max_threads (1..%i)] [-n iterations] [-e nelm] [-d dbd_file] [-o csv_file]\n", argv[0], MAX_THREADS);
+		return 1;
+	}
+
+	if ( dbLoadDatabase( dbd, 0, 0 ) ) {
+		fprintf(stderr, "Unable to load %s\n", dbd);
+		return 1;
+	}
+	genVarBench_registerRecordDeviceDriver( pdbbase );
+
+	if ( createGenVars() || createRecords() ) {
+		fprintf(stderr, "Setup failed\n");
+		return 1;
+	}
+
+	if ( ! out )
+		out = stdout;
+
+	iocInit();
+
+	runBench();
+
+	if ( out != stdout )
+		fclose( out );
+
+	epicsExit( 0 );
+	return 0;
+}
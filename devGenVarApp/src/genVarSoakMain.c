@@ -0,0 +1,414 @@
+/* Large-scale soak/load test IOC for devGenVar.
+ *
+ * iocsh commands:
+ *
+ *   genVarSoakCreate(n_vars, n_lists, db_file, prefix)
+ *       Register 'n_vars' GenVars (as "soak0", "soak1", ... holding
+ *       up to 10000 variables each) spread over
+ *       'n_lists' scan-lists and write a database with one record per
+ *       GenVar to 'db_file'. The record types cycle through all types
+ *       devGenVar supports (and the IOC knows). Input records are
+ *       'I/O Intr' scanned; output records are passive.
+ *       Load the file with dbLoadRecords() before iocInit.
+ *
+ *   genVarSoakStart(n_threads, rate_hz)
+ *       Start 'n_threads' producer threads which update every variable
+ *       and request a scan of every scan-list 'rate_hz' times per
+ *       second (the scan-lists are distributed among the threads).
+ *
+ *   genVarSoakReport(reset)
+ *       Print iocInit duration, resident set size, callback queue
+ *       high-water marks (EPICS >= 7.0.2) and the update rates
+ *       (producer updates and record reads) since the last report.
+ *
+ * See 'stSoak' for an example startup script.
+ */
+#include <epicsExit.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <epicsTypes.h>
+#include <epicsVersion.h>
+#include <iocsh.h>
+#include <initHooks.h>
+#include <callback.h>
+#include <dbAccess.h>
+#include <dbStaticLib.h>
+#include <dbScan.h>
+#include <errlog.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include <devGenVar.h>
+
+#if defined(EPICS_VERSION_INT) && EPICS_VERSION_INT >= VERSION_INT(7,0,2,0)
+#define HAVE_CALLBACK_QUEUE_STATUS
+#endif
+
+#define SOAK_NELM 8
+/* The VME_IO card number is a short; register in chunks */
+#define SOAK_CHUNK 10000
+
+typedef struct SoakType_ {
+	const char *rec;
+	int         out;
+	int         arr;
+	unsigned    dbr_t;
+} SoakType;
+
+static SoakType soakTypes[] = {
+	{ "ai",       0, 0, DBR_LONG  },
+	{ "longin",   0, 0, DBR_LONG  },
+	{ "bi",       0, 0, DBR_LONG  },
+	{ "mbbi",     0, 0, DBR_LONG  },
+#ifdef DBR_INT64
+	{ "int64in",  0, 0, DBR_INT64 },
+#endif
+	{ "waveform", 0, 1, DBR_LONG  },
+	{ "aai",      0, 1, DBR_LONG  },
+	{ "ao",       1, 0, DBR_LONG  },
+	{ "longout",  1, 0, DBR_LONG  },
+	{ "bo",       1, 0, DBR_LONG  },
+	{ "mbbo",     1, 0, DBR_LONG  },
+#ifdef DBR_INT64
+	{ "int64out", 1, 0, DBR_INT64 },
+#endif
+	{ "aao",      1, 1, DBR_LONG  },
+};
+
+#define N_SOAK_TYPES (sizeof(soakTypes)/sizeof(soakTypes[0]))
+
+static DevGenVar      soakVars   = 0;
+static int            soakNVars  = 0;
+static IOSCANPVT     *soakLists  = 0;
+static int            soakNLists = 0;
+
+static epicsTimeStamp initBeg, initEnd;
+
+/* Producer statistics */
+static unsigned long  soakNUpd   = 0;
+static unsigned long  soakNScan  = 0;
+
+typedef struct SoakThr_ {
+	int    first, step;   /* scan-lists handled by this thread */
+	double period;
+} SoakThr;
+
+static void
+soakInitHook(initHookState state)
+{
+	if ( initHookAtBeginning == state )
+		epicsTimeGetCurrent( &initBeg );
+	else if ( initHookAfterIocRunning == state )
+		epicsTimeGetCurrent( &initEnd );
+}
+
+static void
+soakProducer(void *arg)
+{
+SoakThr       *t = arg;
+int            l, i, j;
+DevGenVar      gv;
+epicsTimeStamp next, now;
+double         dly;
+
+	epicsTimeGetCurrent( &next );
+
+	while ( 1 ) {
+		for ( l = t->first; l < soakNLists; l += t->step ) {
+			devGenVarLock( &soakVars[l] );
+			for ( i = l; i < soakNVars; i += soakNLists ) {
+				gv = &soakVars[i];
+#ifdef DBR_INT64
+				if ( DBR_INT64 == gv->dbr_t ) {
+					devGenVarStoreInt64( gv, *(epicsInt64*)gv->data_p + 1 );
+				} else
+#endif
+				for ( j = 0; j < (gv->n_elms ? (int)gv->n_elms : 1); j++ ) {
+					((epicsInt32*)gv->data_p)[j]++;
+				}
+				__atomic_fetch_add( &soakNUpd, 1, __ATOMIC_RELAXED );
+			}
+			devGenVarUnlock( &soakVars[l] );
+			devGenVarScan( &soakVars[l] );
+			__atomic_fetch_add( &soakNScan, 1, __ATOMIC_RELAXED );
+		}
+
+		epicsTimeAddSeconds( &next, t->period );
+		epicsTimeGetCurrent( &now );
+		dly = epicsTimeDiffInSeconds( &next, &now );
+		if ( dly > 0. ) {
+			epicsThreadSleep( dly );
+		} else {
+			/* overloaded; don't try to catch up */
+			next = now;
+		}
+	}
+}
+
+static int
+genVarSoakCreate(int n_vars, int n_lists, const char *db_file, const char *prefix)
+{
+DBENTRY   ent;
+SoakType *avail[N_SOAK_TYPES];
+int       n_avail = 0;
+unsigned  t;
+int       i;
+char      nm[40];
+FILE     *f;
+char     *buf;
+SoakType *typ;
+
+	if ( soakVars ) {
+		errlogPrintf("genVarSoakCreate: already created\n");
+		return -1;
+	}
+	if ( n_vars <= 0 || n_lists <= 0 || n_lists > n_vars || ! db_file ) {
+		errlogPrintf("usage: genVarSoakCreate(n_vars, n_lists, db_file, prefix)\n");
+		return -1;
+	}
+	if ( ! prefix )
+		prefix = "soak";
+
+	/* Only use record types this IOC has */
+	dbInitEntry( pdbbase, &ent );
+	for ( t = 0; t < N_SOAK_TYPES; t++ ) {
+		if ( 0 == dbFindRecordType( &ent, soakTypes[t].rec ) )
+			avail[n_avail++] = &soakTypes[t];
+	}
+	dbFinishEntry( &ent );
+
+	soakVars   = calloc( n_vars, sizeof(*soakVars) );
+	soakLists  = calloc( n_lists, sizeof(*soakLists) );
+	buf        = calloc( n_vars, SOAK_NELM * sizeof(epicsInt64) );
+	if ( ! soakVars || ! soakLists || ! buf ) {
+		errlogPrintf("genVarSoakCreate: no memory\n");
+		return -1;
+	}
+
+	if ( ! (f = fopen( db_file, "w" )) ) {
+		errlogPrintf("genVarSoakCreate: unable to open %s\n", db_file);
+		return -1;
+	}
+
+	devGenVarInit( soakVars, n_vars );
+
+	/* one lock per scan-list; GenVar #l (l < n_lists) owns it */
+	for ( i = 0; i < n_lists; i++ ) {
+		scanIoInit( &soakLists[i] );
+		devGenVarLockCreate( &soakVars[i] );
+	}
+
+	for ( i = 0; i < n_vars; i++ ) {
+		typ = avail[i % n_avail];
+
+		soakVars[i].scan_p     = &soakLists[i % n_lists];
+		soakVars[i].mtx        = soakVars[i % n_lists].mtx;
+		soakVars[i].data_p     = buf + i * SOAK_NELM * sizeof(epicsInt64);
+		soakVars[i].dbr_t      = typ->dbr_t;
+		soakVars[i].n_elms     = typ->arr ? SOAK_NELM : 1;
+
+		fprintf(f, "record(%s, \"%s:%s:%i\") {\n", typ->rec, prefix, typ->rec, i);
+		fprintf(f, "  field(DTYP, \"GenVar\")\n");
+		fprintf(f, "  field(%s,  \"#C%i S0 @soak%i\")\n", typ->out ? "OUT" : "INP", i % SOAK_CHUNK, i / SOAK_CHUNK);
+		if ( ! typ->out )
+			fprintf(f, "  field(SCAN, \"I/O Intr\")\n");
+		if ( typ->arr ) {
+			fprintf(f, "  field(FTVL, \"LONG\")\n");
+			fprintf(f, "  field(NELM, \"%i\")\n", SOAK_NELM);
+		}
+		fprintf(f, "}\n");
+	}
+
+	fclose( f );
+
+	soakNVars  = n_vars;
+	soakNLists = n_lists;
+
+	for ( i = 0; i < n_vars; i += SOAK_CHUNK ) {
+		sprintf( nm, "soak%i", i / SOAK_CHUNK );
+		if ( devGenVarRegister( nm, soakVars + i, n_vars - i < SOAK_CHUNK ? n_vars - i : SOAK_CHUNK ) ) {
+			errlogPrintf("genVarSoakCreate: devGenVarRegister(%s) failed\n", nm);
+			return -1;
+		}
+	}
+
+	printf("genVarSoak: %i variables on %i scan-lists; %i record types; database written to %s\n",
+		n_vars, n_lists, n_avail, db_file);
+	return 0;
+}
+
+static int
+genVarSoakStart(int n_threads, double rate)
+{
+SoakThr *t;
+int      i;
+
+	if ( ! soakVars || n_threads <= 0 || rate <= 0. ) {
+		errlogPrintf("usage: genVarSoakStart(n_threads, rate_hz) -- after genVarSoakCreate()\n");
+		return -1;
+	}
+	if ( n_threads > soakNLists )
+		n_threads = soakNLists;
+
+	if ( ! (t = calloc( n_threads, sizeof(*t) )) ) {
+		errlogPrintf("genVarSoakStart: no memory\n");
+		return -1;
+	}
+
+	for ( i = 0; i < n_threads; i++ ) {
+		t[i].first  = i;
+		t[i].step   = n_threads;
+		t[i].period = 1./rate;
+		epicsThreadMustCreate( "genVarSoak",
+		                       epicsThreadPriorityMedium,
+		                       epicsThreadGetStackSize( epicsThreadStackSmall ),
+		                       soakProducer,
+		                       &t[i] );
+	}
+	return 0;
+}
+
+static long
+soakRssKb()
+{
+#ifdef __linux__
+FILE *f;
+long  sz, rss = -1;
+
+	if ( (f = fopen( "/proc/self/statm", "r" )) ) {
+		if ( 2 != fscanf( f, "%ld %ld", &sz, &rss ) )
+			rss = -1;
+		fclose( f );
+	}
+	return rss < 0 ? -1 : rss * (sysconf( _SC_PAGESIZE ) / 1024);
+#else
+	return -1;
+#endif
+}
+
+static void
+genVarSoakReport(int reset)
+{
+static epicsTimeStamp last;
+static unsigned long  lastUpd, lastScan, lastRd;
+epicsTimeStamp        now;
+unsigned long         upd, scan, rd = 0;
+double                dt;
+long                  rss;
+int                   i;
+#ifdef HAVE_CALLBACK_QUEUE_STATUS
+callbackQueueStats    cbs;
+#endif
+
+	if ( initEnd.secPastEpoch )
+		printf("iocInit:           %.3f s\n", epicsTimeDiffInSeconds( &initEnd, &initBeg ));
+
+	if ( (rss = soakRssKb()) >= 0 )
+		printf("RSS:               %ld kB\n", rss);
+	else
+		printf("RSS:               n/a\n");
+
+#ifdef HAVE_CALLBACK_QUEUE_STATUS
+	if ( 0 == callbackQueueStatus( reset, &cbs ) ) {
+		printf("Callback queues:   size %i; high-water marks (low/medium/high): %i/%i/%i; overflows: %i/%i/%i\n",
+			cbs.size,
+			cbs.maxUsed[priorityLow],     cbs.maxUsed[priorityMedium],     cbs.maxUsed[priorityHigh],
+			cbs.numOverflow[priorityLow], cbs.numOverflow[priorityMedium], cbs.numOverflow[priorityHigh]);
+	}
+#else
+	printf("Callback queues:   n/a (requires EPICS >= 7.0.2)\n");
+#endif
+
+	for ( i = 0; i < soakNVars; i++ )
+		rd += soakVars[i].stats.n_rd;
+	upd  = soakNUpd;
+	scan = soakNScan;
+
+	epicsTimeGetCurrent( &now );
+	if ( last.secPastEpoch && (dt = epicsTimeDiffInSeconds( &now, &last )) > 0. ) {
+		printf("Updates:           %.0f /s (producers)\n",   (double)(upd  - lastUpd )/dt);
+		printf("Scans:             %.0f /s (requested)\n",   (double)(scan - lastScan)/dt);
+		printf("Record reads:      %.0f /s (end-to-end)\n",  (double)(rd   - lastRd  )/dt);
+	} else {
+		printf("Updates/scans/record reads: %lu/%lu/%lu (rates available from the next report on)\n", upd, scan, rd);
+	}
+
+	last     = now;
+	lastUpd  = upd;
+	lastScan = scan;
+	lastRd   = rd;
+}
+
+static const iocshArg genVarSoakCreateArg0 = { "n_vars",  iocshArgInt    };
+static const iocshArg genVarSoakCreateArg1 = { "n_lists", iocshArgInt    };
+static const iocshArg genVarSoakCreateArg2 = { "db_file", iocshArgString };
+static const iocshArg genVarSoakCreateArg3 = { "prefix",  iocshArgString };
+
+static const iocshArg *genVarSoakCreateArgs[] = {
+	&genVarSoakCreateArg0,
+	&genVarSoakCreateArg1,
+	&genVarSoakCreateArg2,
+	&genVarSoakCreateArg3,
+};
+
+static const iocshFuncDef genVarSoakCreateDef = { "genVarSoakCreate", 4, genVarSoakCreateArgs };
+
+static void
+genVarSoakCreateCall(const iocshArgBuf *a)
+{
+	genVarSoakCreate( a[0].ival, a[1].ival, a[2].sval, a[3].sval );
+}
+
+static const iocshArg genVarSoakStartArg0 = { "n_threads", iocshArgInt    };
+static const iocshArg genVarSoakStartArg1 = { "rate_hz",   iocshArgDouble };
+
+static const iocshArg *genVarSoakStartArgs[] = {
+	&genVarSoakStartArg0,
+	&genVarSoakStartArg1,
+};
+
+static const iocshFuncDef genVarSoakStartDef = { "genVarSoakStart", 2, genVarSoakStartArgs };
+
+static void
+genVarSoakStartCall(const iocshArgBuf *a)
+{
+	genVarSoakStart( a[0].ival, a[1].dval );
+}
+
+static const iocshArg genVarSoakReportArg0 = { "reset", iocshArgInt };
+
+static const iocshArg *genVarSoakReportArgs[] = {
+	&genVarSoakReportArg0,
+};
+
+static const iocshFuncDef genVarSoakReportDef = { "genVarSoakReport", 1, genVarSoakReportArgs };
+
+static void
+genVarSoakReportCall(const iocshArgBuf *a)
+{
+	genVarSoakReport( a[0].ival );
+}
+
+int
+main(int argc, char **argv)
+{
+	initHookRegister( soakInitHook );
+
+	iocshRegister( &genVarSoakCreateDef, genVarSoakCreateCall );
+	iocshRegister( &genVarSoakStartDef,  genVarSoakStartCall  );
+	iocshRegister( &genVarSoakReportDef, genVarSoakReportCall );
+
+	if ( argc >= 2 ) {
+		iocsh( argv[1] );
+		epicsThreadSleep(0.2);
+	}
+	iocsh( 0 );
+	epicsExit( 0 );
+	return( 0 );
+}
@@ -0,0 +1,108 @@
+/* C++ GenVars (devGenVarCxx.h) for the test IOC */
+
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <dbScan.h>
+#include <errlog.h>
+#include <alarm.h>
+
+#include <devGenVarCxx.h>
+
+#include "genVarTestCxx.h"
+
+using devGenVar::GenVar;
+
+/* written by the 'cxxW' longout; the thread waits for it */
+static GenVar<epicsInt32>        cxxW;
+/* counter; every other update is suppressed */
+static GenVar<epicsInt32>        cxxL;
+/* shares the scan-list with cxxL; only read when marked dirty */
+static GenVar<epicsFloat64, 4>   cxxD;
+#ifdef DBR_INT64
+static GenVar<epicsUInt64>       cxxQ;
+#endif
+
+static IOSCANPVT                 cxxList;
+
+static void
+cxxT(void *arg)
+{
+const GenVar<epicsInt32> &w = cxxW;
+epicsTimeStamp now;
+epicsFloat64   d[4];
+epicsInt32     v;
+unsigned       cnt = 0;
+unsigned       i;
+
+	while ( 1 ) {
+		/* returns early if the longout was written */
+		cxxW.wait( 2.0 );
+		epicsTimeGetCurrent( &now );
+
+		cnt++;
+		cxxL.update( cnt / 2, &now );
+
+		cxxW.lock();
+			v = w.data()[0];
+		cxxW.unlock();
+
+		if ( 0 == (cnt % 4) ) {
+			for ( i = 0; i < 4; i++ )
+				d[i] = 0.25 * cnt + i;
+			cxxD.updateArr( d, &now );
+		} else {
+			{
+				GenVar<epicsFloat64, 4>::Guard g( cxxD );
+				cxxD.data()[0] = v;
+			}
+			cxxD.markDirty();
+			cxxD.scan();
+		}
+		if ( v < 0 )
+			cxxD.setStatus( LOW_ALARM, MINOR_ALARM, &now );
+		else
+			cxxD.setStatus( NO_ALARM, NO_ALARM, &now );
+
+#ifdef DBR_INT64
+		cxxQ.set( cxxQ.get() + 1 );
+		devGenVarAddUInt64( cxxQ.raw(), 1 );
+		cxxQ.scan();
+#endif
+	}
+}
+
+void
+genVarTestCxxInit(void)
+{
+	if (    cxxW.lockCreate()
+	     || cxxW.evtCreate()
+	     || cxxW.registerAs( "cxxW" ) ) {
+		errlogPrintf("genVarTestCxxInit: cxxW failed\n");
+	}
+
+	scanIoInit( &cxxList );
+
+	cxxL.setScanPvt( &cxxList );
+	cxxL.setOpts( DEV_GEN_VAR_OPT_DIRTY );
+	if ( cxxL.lockCreate() || cxxL.registerAs( "cxxL" ) ) {
+		errlogPrintf("genVarTestCxxInit: cxxL failed\n");
+	}
+
+	cxxD.setScanPvt( &cxxList );
+	cxxD.setOpts( DEV_GEN_VAR_OPT_DIRTY );
+	if ( cxxD.lockCreate() || cxxD.registerAs( "cxxD" ) ) {
+		errlogPrintf("genVarTestCxxInit: cxxD failed\n");
+	}
+
+#ifdef DBR_INT64
+	if ( cxxQ.lockCreate() || cxxQ.scanPvtCreate() || cxxQ.registerAs( "cxxQ" ) ) {
+		errlogPrintf("genVarTestCxxInit: cxxQ failed\n");
+	}
+#endif
+
+	epicsThreadMustCreate("cxxThread",
+	                      epicsThreadPriorityLow,
+	                      epicsThreadGetStackSize(epicsThreadStackMedium),
+	                      cxxT,
+	                      0 );
+}
@@ -0,0 +1,16 @@
+#ifndef GEN_VAR_TEST_CXX_H
+#define GEN_VAR_TEST_CXX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Create, register and start the C++ GenVars of the test IOC */
+void
+genVarTestCxxInit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,10 +3,13 @@
 #include <iocsh.h>
 #include <dbScan.h>
 #include <errlog.h>
+#include <stddef.h>
 #include <alarm.h>
 
 #include <devGenVar.h>
 
+#include "genVarTestCxx.h"
+
 #include <dbFldTypes.h>
 #include <epicsTypes.h>
 
@@ -15,9 +18,45 @@ epicsInt32   genTestL     = -1;
 epicsUInt32  genTestL1    = -2;
 
 epicsUInt32  genAsyncL    = 0;
+epicsInt32   genAsyncI    = 0;
+
+epicsInt32   genFifoO     = 0;    /* not written (FIFO)           */
+epicsInt32   genFifoOSum  = 0;    /* sum of all values dequeued   */
+epicsFloat64 genFifoI     = 0.;   /* not read (FIFO)              */
+
+epicsUInt32  genAtomB     = 0;
+
+epicsInt32   genDeferL    = 0;
+
+typedef struct GenStruct_ {
+	epicsInt32   cnt;
+	epicsFloat64 volt;
+	epicsInt16   arr[4];
+} GenStruct;
+
+GenStruct    genStruct;
+
+/* share a scan-list; 'slow' changes every 5th scan (DEV_GEN_VAR_OPT_DIRTY) */
+epicsInt32   genDirtyFast = 0;
+epicsInt32   genDirtySlow = 0;
+
+char         genStr[MAX_STRING_SIZE] = "hello";
+char         genLStr[256]            = "a string which is longer than forty characters (lsi/lso)";
+
+epicsInt16   genTestA[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+epicsFloat64 genSeqD      = 0.;
+
+typedef struct GenSnapData_ {
+	epicsInt32   cnt;
+	epicsFloat64 volt;
+} GenSnapData;
 
 static IOSCANPVT    listS;
 static IOSCANPVT    listL;
+static IOSCANPVT    listA;
+static IOSCANPVT    listQ;
+static IOSCANPVT    listG;
 
 static DevGenVarRec testS[] = {
 	DEV_GEN_VAR_INIT( &listS, 0, 0, &genTestS, DBR_USHORT )
@@ -28,30 +67,153 @@ static DevGenVarRec testL[] = {
 	DEV_GEN_VAR_INIT( &listL, 0, 0, &genTestL1, DBR_ULONG )
 };
 
+static DevGenVarRec testA[] = {
+	DEV_GEN_VAR_INIT_ARR( &listA, 0, 0, genTestA, DBR_SHORT, sizeof(genTestA)/sizeof(genTestA[0]) )
+};
+
+/* seqlock mode; written by ioscnT only */
+static DevGenVarRec seqD[] = {
+	DEV_GEN_VAR_INIT( &listQ, 0, 0, &genSeqD, DBR_DOUBLE )
+};
+
+/* snapshot group; published by ioscnT */
+static DevGenVarSnap snapG;
+static DevGenVarRec  snapV[2];
+
 static DevGenVarRec asyncL[] = {
 	DEV_GEN_VAR_INIT( 0, 0, 0, &genAsyncL, DBR_ULONG )
 };
 
+/* asynchronous input; the value is produced on demand by asyncIT */
+static DevGenVarRec asyncI[] = {
+	DEV_GEN_VAR_INIT( 0, 0, 0, &genAsyncI, DBR_LONG )
+};
+
+/* output FIFO; drained by fifoOT */
+static DevGenVarRec fifoO[] = {
+	DEV_GEN_VAR_INIT( 0, 0, 0, &genFifoO, DBR_LONG )
+};
+
+/* input FIFO; bursts pushed by ioscnT */
+static IOSCANPVT    listF;
+
+static DevGenVarRec fifoI[] = {
+	DEV_GEN_VAR_INIT( &listF, 0, 0, &genFifoI, DBR_DOUBLE )
+};
+
+/* lock-free bits; bit 0 written by a bo, bit 8 toggled by ioscnT */
+static DevGenVarRec atomB[] = {
+	DEV_GEN_VAR_INIT( 0, 0, 0, &genAtomB, DBR_ULONG )
+};
+
+/* asynchronous output, phase 2 deferred to a callback thread */
+static DevGenVarRec deferL[] = {
+	DEV_GEN_VAR_INIT( 0, 0, 0, &genDeferL, DBR_LONG )
+};
+
+/* struct layout; records reference "genStruct.<member>" */
+static IOSCANPVT    listT;
+
+static const DevGenVarMemberRec genStructMembers[] = {
+	DEV_GEN_VAR_MEMBER(     GenStruct, cnt,  DBR_LONG   ),
+	DEV_GEN_VAR_MEMBER(     GenStruct, volt, DBR_DOUBLE ),
+	DEV_GEN_VAR_MEMBER_ARR( GenStruct, arr,  DBR_SHORT  ),
+};
+
+static IOSCANPVT    listD;
+
+static DevGenVarRec dirtyV[] = {
+	DEV_GEN_VAR_INIT( &listD, 0, 0, &genDirtyFast, DBR_LONG ),
+	DEV_GEN_VAR_INIT( &listD, 0, 0, &genDirtySlow, DBR_LONG )
+};
+
+static DevGenVarRec strS[] = {
+	DEV_GEN_VAR_INIT( 0, 0, 0, genStr, DBR_STRING )
+};
+
+static DevGenVarRec strL[] = {
+	DEV_GEN_VAR_INIT_ARR( 0, 0, 0, genLStr, DBR_CHAR, sizeof(genLStr) )
+};
+
+static DevGenVarRec structT[] = {
+	DEV_GEN_VAR_INIT( &listT, 0, 0, &genStruct, 0 )
+};
+
 static void
 asyncT(void *arg)
 {
+epicsUInt32 val;
+
 	asyncL[0].ts.nsec = 44444444;
 	while ( 1 ) {
 		epicsEventWait( asyncL[0].evt );
-		{
+		/* complete every pending record; each write keeps its value */
+		while ( devGenVarProcPendingGet( asyncL, &val, 0, 0, 0 ) >= 0 ) {
 			devGenVarLock( asyncL );
 				asyncL[0].ts.nsec++;
 				asyncL[0].stat    = WRITE_ALARM;
 				asyncL[0].sevr    = MINOR_ALARM;
-				devGenVarProcComplete( asyncL );
 			devGenVarUnlock( asyncL );
+			/* must not hold the GenVar's lock */
+			devGenVarProcComplete( asyncL );
+		}
+	}
+}
+
+static void
+asyncIT(void *arg)
+{
+	while ( 1 ) {
+		epicsEventWait( asyncI[0].evt );
+		while ( devGenVarProcPending( asyncI, 0 ) > 0 ) {
+			devGenVarLock( asyncI );
+				genAsyncI++;
+				epicsTimeGetCurrent( &asyncI[0].ts );
+				asyncI[0].stat = 0;
+				asyncI[0].sevr = 0;
+			devGenVarUnlock( asyncI );
+			devGenVarProcComplete( asyncI );
+		}
+	}
+}
+
+static void
+deferT(void *arg)
+{
+epicsInt32 val;
+
+	while ( 1 ) {
+		epicsEventWait( deferL[0].evt );
+		while ( devGenVarProcPendingGet( deferL, &val, 0, 0, 0 ) >= 0 ) {
+			devGenVarLock( deferL );
+				epicsTimeGetCurrent( &deferL[0].ts );
+			devGenVarUnlock( deferL );
+			/* returns right away; the record completes in a callback thread */
+			devGenVarProcComplete( deferL );
 		}
 	}
 }
 
+static void
+fifoOT(void *arg)
+{
+epicsInt32 val;
+
+	while ( 1 ) {
+		devGenVarWait( fifoO, -1. );
+		while ( devGenVarDequeue( fifoO, &val, 0, 0, 0 ) > 0 )
+			genFifoOSum += val;
+	}
+}
+
 static void
 ioscnT(void *arg)
 {
+GenSnapData *d;
+epicsFloat64 smp;
+epicsInt32   v;
+int          i;
+
 	while ( 1 ) {
 		epicsThreadSleep(2.0);
 		devGenVarLock( & testS[0] );
@@ -60,6 +222,48 @@ ioscnT(void *arg)
 			scanIoRequest( listS );
 		}
 		devGenVarUnlock( & testS[0] );
+
+		devGenVarSeqBegin( &seqD[0] );
+			genSeqD += 0.5;
+			epicsTimeGetCurrent( &seqD[0].ts );
+		devGenVarSeqEnd( &seqD[0] );
+		devGenVarScan( &seqD[0] );
+
+		if ( snapG && (d = devGenVarSnapBack( snapG )) ) {
+			d->cnt++;
+			d->volt = 0.25 * d->cnt;
+			devGenVarSnapPublish( snapG, 0, 0, 0 );
+		}
+
+		devGenVarLock( &structT[0] );
+			genStruct.cnt++;
+			genStruct.volt   = 0.5 * genStruct.cnt;
+			genStruct.arr[genStruct.cnt & 3] = genStruct.cnt;
+			/* members use the template's timestamp and alarm */
+			epicsTimeGetCurrent( &structT[0].ts );
+			structT[0].stat = (genStruct.cnt & 3) ? NO_ALARM : HIGH_ALARM;
+			structT[0].sevr = (genStruct.cnt & 3) ? NO_ALARM : MINOR_ALARM;
+		devGenVarUnlock( &structT[0] );
+		devGenVarScan( &structT[0] );
+
+		if ( genAtomB & 0x100 )
+			devGenVarClearBits( &atomB[0], 0x100, 0 );
+		else
+			devGenVarSetBits( &atomB[0], 0x100, 0 );
+
+		/* both update the shared scan-list; the slow record only reads on change */
+		v = genDirtyFast + 1;
+		devGenVarUpdate( &dirtyV[0], &v, 0 );
+		if ( 0 == v % 5 ) {
+			v = genDirtySlow + 1;
+			devGenVarUpdate( &dirtyV[1], &v, 0 );
+		}
+
+		/* a burst; the record processes once per sample */
+		for ( i = 0; i < 4; i++ ) {
+			smp = 0.1 * i;
+			devGenVarPush( &fifoI[0], &smp, 1, 0, 0, 0 );
+		}
 	}
 }
 
@@ -79,6 +283,32 @@ main(int argc, char **argv)
 		errlogPrintf("devGenVarRegister(testL) failed\n");
 	}
 
+	scanIoInit( &listA );
+	devGenVarLockCreate( &testA[0] );
+	if ( devGenVarRegister( "testA", testA, sizeof(testA)/sizeof(testA[0])) ) {
+		errlogPrintf("devGenVarRegister(testA) failed\n");
+	}
+
+	scanIoInit( &listQ );
+	seqD[0].opts = DEV_GEN_VAR_OPT_SEQLOCK;
+	if ( devGenVarRegister( "seqD", seqD, sizeof(seqD)/sizeof(seqD[0])) ) {
+		errlogPrintf("devGenVarRegister(seqD) failed\n");
+	}
+
+	scanIoInit( &listG );
+	devGenVarInit( snapV, sizeof(snapV)/sizeof(snapV[0]) );
+	if ( ! (snapG = devGenVarSnapCreate( sizeof(GenSnapData), &listG )) ) {
+		errlogPrintf("devGenVarSnapCreate(snapV) failed\n");
+	} else {
+		snapV[0].dbr_t = DBR_LONG;
+		snapV[1].dbr_t = DBR_DOUBLE;
+		if (    devGenVarSnapAttach( &snapV[0], snapG, offsetof(GenSnapData, cnt)  )
+		     || devGenVarSnapAttach( &snapV[1], snapG, offsetof(GenSnapData, volt) )
+		     || devGenVarRegister( "snapV", snapV, sizeof(snapV)/sizeof(snapV[0]) ) ) {
+			errlogPrintf("devGenVarRegister(snapV) failed\n");
+		}
+	}
+
 	devGenVarLockCreate( &asyncL[0] );
 	devGenVarEvtCreate(  &asyncL[0] );
 	if ( devGenVarRegister( "asyncL", asyncL, sizeof(asyncL)/sizeof(asyncL[0])) ) {
@@ -91,6 +321,84 @@ main(int argc, char **argv)
 	                      asyncT,
 	                      0 );
 
+	devGenVarLockCreate( &asyncI[0] );
+	devGenVarEvtCreate(  &asyncI[0] );
+	if ( devGenVarRegister( "asyncI", asyncI, sizeof(asyncI)/sizeof(asyncI[0])) ) {
+		errlogPrintf("devGenVarRegister(asyncI) failed\n");
+	}
+
+	epicsThreadMustCreate("asyncInpThread",
+	                      epicsThreadPriorityLow,
+	                      epicsThreadGetStackSize(epicsThreadStackMedium),
+	                      asyncIT,
+	                      0 );
+
+	devGenVarLockCreate( &fifoO[0] );
+	devGenVarEvtCreate(  &fifoO[0] );
+	if (    devGenVarFifoCreate( &fifoO[0], 16, DEV_GEN_VAR_FIFO_OUT )
+	     || devGenVarRegister( "fifoO", fifoO, sizeof(fifoO)/sizeof(fifoO[0])) ) {
+		errlogPrintf("devGenVarRegister(fifoO) failed\n");
+	}
+
+	scanIoInit( &listF );
+	if (    devGenVarFifoCreate( &fifoI[0], 64, DEV_GEN_VAR_FIFO_IN )
+	     || devGenVarRegister( "fifoI", fifoI, sizeof(fifoI)/sizeof(fifoI[0])) ) {
+		errlogPrintf("devGenVarRegister(fifoI) failed\n");
+	}
+
+	devGenVarLockCreate( &atomB[0] );
+	atomB[0].opts = DEV_GEN_VAR_OPT_ATOMIC;
+	if ( devGenVarRegister( "atomB", atomB, sizeof(atomB)/sizeof(atomB[0])) ) {
+		errlogPrintf("devGenVarRegister(atomB) failed\n");
+	}
+
+	devGenVarLockCreate( &deferL[0] );
+	devGenVarEvtCreate(  &deferL[0] );
+	deferL[0].opts = DEV_GEN_VAR_OPT_DEFER;
+	if ( devGenVarRegister( "deferL", deferL, sizeof(deferL)/sizeof(deferL[0])) ) {
+		errlogPrintf("devGenVarRegister(deferL) failed\n");
+	}
+
+	epicsThreadMustCreate("deferThread",
+	                      epicsThreadPriorityLow,
+	                      epicsThreadGetStackSize(epicsThreadStackMedium),
+	                      deferT,
+	                      0 );
+
+	scanIoInit( &listD );
+	devGenVarLockCreate( &dirtyV[0] );
+	dirtyV[1].mtx  = dirtyV[0].mtx;
+	dirtyV[0].opts = DEV_GEN_VAR_OPT_DIRTY;
+	dirtyV[1].opts = DEV_GEN_VAR_OPT_DIRTY;
+	if ( devGenVarRegister( "dirtyV", dirtyV, sizeof(dirtyV)/sizeof(dirtyV[0])) ) {
+		errlogPrintf("devGenVarRegister(dirtyV) failed\n");
+	}
+
+	devGenVarLockCreate( &strS[0] );
+	if ( devGenVarRegister( "strS", strS, sizeof(strS)/sizeof(strS[0])) ) {
+		errlogPrintf("devGenVarRegister(strS) failed\n");
+	}
+
+	devGenVarLockCreate( &strL[0] );
+	if ( devGenVarRegister( "strL", strL, sizeof(strL)/sizeof(strL[0])) ) {
+		errlogPrintf("devGenVarRegister(strL) failed\n");
+	}
+
+	scanIoInit( &listT );
+	devGenVarLockCreate( &structT[0] );
+	if ( devGenVarRegisterStruct( "genStruct", structT, genStructMembers,
+	                              sizeof(genStructMembers)/sizeof(genStructMembers[0]) ) ) {
+		errlogPrintf("devGenVarRegisterStruct(genStruct) failed\n");
+	}
+
+	epicsThreadMustCreate("fifoOutThread",
+	                      epicsThreadPriorityLow,
+	                      epicsThreadGetStackSize(epicsThreadStackMedium),
+	                      fifoOT,
+	                      0 );
+
+	genVarTestCxxInit();
+
 	epicsThreadMustCreate("ioscnThread",
 	                      epicsThreadPriorityLow,
 	                      epicsThreadGetStackSize(epicsThreadStackMedium),
@@ -106,6 +414,7 @@ main(int argc, char **argv)
 	testL[1].ts.nsec = 12345678;
 	scanIoRequest( listL );
 	scanIoRequest( listS );
+	scanIoRequest( listA );
 	iocsh( 0 );
 	epicsExit( 0 );
 	return( 0 );